@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "ActionLog.h"
 
 enum class SettlementType;
 enum class FacilityCategory;
@@ -16,12 +17,19 @@ class BaseAction{
         virtual void act(Simulation& simulation)=0;
         virtual const string toString() const=0;
         virtual BaseAction* clone() const = 0;
+        // Writes the action's code and arguments, for ActionLog
+        virtual void encode(ActionLog &log) const = 0;
+        // Rebuilds an action written by encode
+        static BaseAction *decode(ActionLog::Reader &reader, ActionStatus status);
+        const string &getErrorMsg() const;
+        // Whether acting can change the simulation (and so can be undone)
+        virtual bool changesState() const;
         virtual ~BaseAction() = default;
 
     protected:
         void complete();
         void error(string errorMsg);
-        const string &getErrorMsg() const;
+        void setStatus(ActionStatus status); // Without reporting anything
 
     private:
         ActionStatus status;
@@ -34,6 +42,8 @@ class SimulateStep : public BaseAction {
         SimulateStep(const int numOfSteps);
         void act(Simulation &simulation) override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
         SimulateStep *clone() const override;
     private:
         const int numOfSteps;
@@ -44,6 +54,8 @@ class AddPlan : public BaseAction {
         AddPlan(const string &settlementName, const string &selectionPolicy);
         void act(Simulation &simulation) override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
         AddPlan *clone() const override;
     private:
         const string settlementName;
@@ -57,6 +69,8 @@ class AddSettlement : public BaseAction {
         void act(Simulation &simulation) override;
         AddSettlement *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
     private:
         const string settlementName;
         const SettlementType settlementType;
@@ -70,6 +84,8 @@ class AddFacility : public BaseAction {
         void act(Simulation &simulation) override;
         AddFacility *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
     private:
         const string facilityName;
         const FacilityCategory facilityCategory;
@@ -86,6 +102,7 @@ class PrintPlanStatus: public BaseAction {
         void act(Simulation &simulation) override;
         PrintPlanStatus *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
     private:
         const int planId;
 };
@@ -97,6 +114,8 @@ class ChangePlanPolicy : public BaseAction {
         void act(Simulation &simulation) override;
         ChangePlanPolicy *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
     private:
         const int planId;
         const string newPolicy;
@@ -109,6 +128,7 @@ class PrintActionsLog : public BaseAction {
         void act(Simulation &simulation) override;
         PrintActionsLog *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
     private:
 };
 
@@ -118,24 +138,101 @@ class Close : public BaseAction {
         void act(Simulation &simulation) override;
         Close *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
     private:
 };
 
+// Without a name, backup and restore use the single unnamed backup
 class BackupSimulation : public BaseAction {
     public:
-        BackupSimulation();
+        BackupSimulation(const string &snapshotName = "");
         void act(Simulation &simulation) override;
         BackupSimulation *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
     private:
+        const string snapshotName;
 };
 
 
 class RestoreSimulation : public BaseAction {
     public:
-        RestoreSimulation();
+        RestoreSimulation(const string &snapshotName = "");
         void act(Simulation &simulation) override;
         RestoreSimulation *clone() const override;
         const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
+    private:
+        const string snapshotName;
+};
+
+class PrintSnapshots : public BaseAction {
+    public:
+        PrintSnapshots();
+        void act(Simulation &simulation) override;
+        PrintSnapshots *clone() const override;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
+    private:
+};
+
+class DropSnapshot : public BaseAction {
+    public:
+        DropSnapshot(const string &snapshotName);
+        void act(Simulation &simulation) override;
+        DropSnapshot *clone() const override;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
+    private:
+        const string snapshotName;
+};
+
+// Goes back to the state from before the last count actions that changed it
+class Undo : public BaseAction {
+    public:
+        Undo(int count = 1);
+        void act(Simulation &simulation) override;
+        Undo *clone() const override;
+        int getCount() const;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
+    private:
+        const int count;
+};
+
+class SaveSimulation : public BaseAction {
+    public:
+        SaveSimulation(const string &filePath);
+        void act(Simulation &simulation) override;
+        SaveSimulation *clone() const override;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
+    private:
+        const string filePath;
+};
+
+class LoadSimulation : public BaseAction {
+    public:
+        LoadSimulation(const string &filePath);
+        void act(Simulation &simulation) override;
+        LoadSimulation *clone() const override;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
+        bool changesState() const override;
+    private:
+        const string filePath;
+};
+
+// An action read back from a snapshot file. It prints as the action it records and
+// keeps that action's status; acting on it does nothing.
+class RecordedAction : public BaseAction {
+    public:
+        RecordedAction(const string &description, ActionStatus status);
+        void act(Simulation &simulation) override;
+        RecordedAction *clone() const override;
+        const string toString() const override;
+        void encode(ActionLog &log) const override;
     private:
+        const string description;
 };
\ No newline at end of file
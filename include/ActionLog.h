@@ -0,0 +1,84 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CowVector.h"
+using std::string;
+using std::vector;
+
+class BaseAction;
+enum class ActionStatus;
+
+// Kinds of logged actions, stored as the first byte of their record
+enum class ActionCode : unsigned char {
+    STEP,
+    ADD_PLAN,
+    ADD_SETTLEMENT,
+    ADD_FACILITY,
+    PLAN_STATUS,
+    CHANGE_POLICY,
+    PRINT_LOG,
+    CLOSE,
+    BACKUP,
+    RESTORE,
+    SNAPSHOTS,
+    DROP_SNAPSHOT,
+    UNDO,
+    SAVE,
+    LOAD,
+    RECORDED,
+};
+
+// Append-only log of the actions a simulation ran. Each action is kept as a short
+// record: its code, its status and its arguments, with integers as varints and strings
+// as ids into a table of distinct strings. Actions are only rebuilt, by Reader, when
+// the log is read.
+// The bytes are in a CowVector, so copies of a simulation share their common prefix of
+// the log. The string table only ever grows, so copies share it outright.
+class ActionLog {
+    public:
+        // Rebuilds the logged actions in order
+        class Reader {
+            public:
+                explicit Reader(const ActionLog &log);
+                bool atEnd() const;
+                std::unique_ptr<BaseAction> next();
+
+                // For BaseAction::decode
+                int readInt();
+                const string &readString();
+                unsigned char readByte();
+
+            private:
+                unsigned long long readUnsigned();
+
+                const ActionLog &log;
+                size_t position;
+        };
+
+        ActionLog();
+        size_t size() const;
+        bool empty() const;
+        void append(const BaseAction &action);
+        void clear();
+
+        // For BaseAction::encode
+        void writeCode(ActionCode code);
+        void writeInt(int value);
+        void writeString(const string &value);
+        void writeByte(unsigned char value);
+
+    private:
+        struct StringTable {
+            StringTable();
+            vector<string> values;
+            std::unordered_map<string, unsigned int> ids;
+        };
+
+        void writeUnsigned(unsigned long long value);
+
+        CowVector<unsigned char> bytes;
+        size_t count;
+        std::shared_ptr<StringTable> strings;
+};
@@ -7,4 +7,7 @@
 class Auxiliary{
     public:
         static std::vector<std::string> parseArguments(const std::string& line);
+        // Parses text[0, length) as a whole decimal int, with an optional sign. False if
+        // it is anything else or out of range; nothing is allocated.
+        static bool parseInt(const char *text, size_t length, int &value);
 };
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "CowMap.h"
+using std::vector;
+
+// Answers BalancedSelection's question without scanning the catalog.
+// With a = life, b = economy, c = environment totals, max - min of (a, b, c) equals
+// max(|a - b|, |b - c|, |a - c|). Each facility is stored as the point
+// (life - economy, economy - environment), and a pick is the point nearest to the
+// plan's own differences, negated, under the norm max(|x|, |y|, |x + y|).
+// Points are kept in k-d trees of sizes 2^k (merged like a binary counter on insert).
+// A tree never changes once built, so copies of the index share their trees.
+// Ties go to the lowest catalog index, as in a full scan.
+class BalanceIndex {
+    public:
+        BalanceIndex();
+        void add(int index, int lifeQualityScore, int economyScore, int environmentScore);
+        // Catalog index of the most balanced pick, or -1 if the index is empty
+        int findMostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const;
+        void clear();
+
+    private:
+        struct Point {
+            int x, y;
+            int index; // Lowest catalog index with these differences
+        };
+        struct Node {
+            int minX, maxX, minY, maxY;
+            int minIndex;
+        };
+        struct Tree {
+            Tree();
+            vector<Point> points; // In k-d order: the point of range [lo, hi) sits at (lo + hi) / 2
+            vector<Node> nodes;   // Bounds of the subtree rooted at each point
+        };
+
+        static void build(Tree &tree);
+        static void build(Tree &tree, size_t lo, size_t hi, int depth);
+        static void search(const Tree &tree, size_t lo, size_t hi, int depth, long long offsetX, long long offsetY,
+                           long long &bestBalance, int &bestIndex);
+
+        vector<std::shared_ptr<const Tree>> levels; // levels[k] is empty or holds 2^k points
+        CowMap<long long, int> seen; // Point -> the catalog index that has it
+};
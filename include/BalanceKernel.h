@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// Scoring loop behind BalancedSelection. For every catalog entry it adds the entry's
+// scores to the plan's and measures max - min of the three totals; the result is the
+// first index with the smallest spread. The SIMD version is picked once at runtime.
+class BalanceKernel {
+    public:
+        static int findMostBalanced(const int *lifeQualityScores, const int *economyScores, const int *environmentScores,
+                                    size_t count, int lifeQualityScore, int economyScore, int environmentScore);
+        static const char *getImplementationName();
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <ostream>
+
+class Simulation;
+
+// Timings behind the command line's --bench-* options. Each runs on copies of the loaded
+// simulation, which stays as it was, and writes a short report.
+class Benchmark {
+    public:
+        // Adds plans plans, spread over the settlements in turn, and times steps steps
+        // of them: once with "bal" plans and once with "opt" plans. Also names the
+        // balance kernel's path (avx2, sse4.1 or scalar). Throws if the simulation
+        // has no settlements or facilities.
+        static void planning(const Simulation &simulation, int plans, int steps, std::ostream &out);
+        // Feeds count command lines through actionHandler, with what they print dropped.
+        // Times lines whose keyword is unknown, which only pay for splitting and the
+        // lookup, and a mix of cheap commands, which are also parsed, run and logged.
+        // The copy is not started, so nothing goes to the undo journal or --log-file.
+        static void commands(const Simulation &simulation, int count, std::ostream &out);
+};
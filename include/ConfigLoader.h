@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+using std::string;
+
+class Simulation;
+
+// Reads a config file into a simulation. The file is mapped and cut into chunks at line
+// boundaries, which are tokenized in place and parsed on the shared thread pool. The
+// parsed settlement, facility and plan lines are then applied straight to the simulation
+// in file order, without building actions, so the result is the same as reading the file
+// line by line. Other lines, and lines the simulation turns down (such as a settlement
+// that already exists), go through actionHandler like typed commands, so they are
+// reported the same way. A malformed line throws, naming its file and line. A snapshot
+// file, such as a config compiled with --compile-config, is loaded as a snapshot.
+class ConfigLoader {
+    public:
+        static void load(Simulation &simulation, const string &path);
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+using std::vector;
+
+// A hash map whose copies share storage, for the name lookups that sit next to a
+// CowVector. Entries live in a trie keyed by the hash, 16 children per level, with up
+// to LEAF_SIZE entries in each leaf. Nodes are held by shared pointers, so copying is
+// O(1), and an insert copies only the nodes on its path that another copy still uses.
+// Entries can be added but not removed. Thread rules are those of CowVector.
+template <typename Key, typename Value>
+class CowMap {
+    public:
+        CowMap() : root(), count(0) {}
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // The value for key, or nullptr if there is none
+        const Value *find(const Key &key) const
+        {
+            size_t hash = std::hash<Key>()(key);
+            const Node *node = root.get();
+            for (int depth = 0; node != nullptr && node->branch; depth++)
+            {
+                node = node->children[digit(hash, depth)].get();
+            }
+            if (node == nullptr)
+            {
+                return nullptr;
+            }
+            for (const Entry &entry : node->entries)
+            {
+                if (entry.first == key)
+                {
+                    return &entry.second;
+                }
+            }
+            return nullptr;
+        }
+
+        bool contains(const Key &key) const { return find(key) != nullptr; }
+
+        // Returns false, and changes nothing, if the key is already there
+        bool insert(const Key &key, const Value &value)
+        {
+            if (contains(key))
+            {
+                return false;
+            }
+            size_t hash = std::hash<Key>()(key);
+            std::shared_ptr<Node> *slot = &root;
+            int depth = 0;
+            while (ownNode(*slot).branch)
+            {
+                slot = &(*slot)->children[digit(hash, depth)];
+                depth++;
+            }
+            Node &leaf = **slot;
+            leaf.entries.push_back(Entry(key, value));
+            if (leaf.entries.size() > LEAF_SIZE)
+            {
+                split(leaf, depth);
+            }
+            count++;
+            return true;
+        }
+
+        void clear()
+        {
+            root.reset();
+            count = 0;
+        }
+
+    private:
+        typedef std::pair<Key, Value> Entry;
+        static const int FANOUT_BITS = 4;
+        static const size_t FANOUT = 1 << FANOUT_BITS;
+        static const size_t LEAF_SIZE = 8;
+        static const int MAX_DEPTH = static_cast<int>(sizeof(size_t) * 8 / FANOUT_BITS);
+
+        struct Node {
+            Node() : children(), entries(), branch(false) {}
+            std::shared_ptr<Node> children[FANOUT]; // Branch nodes only
+            vector<Entry> entries;                  // Leaves only
+            bool branch;
+        };
+
+        static size_t digit(size_t hash, int depth)
+        {
+            return (hash >> (depth * FANOUT_BITS)) & (FANOUT - 1);
+        }
+
+        // Writable node; creates it if missing and copies it first if it is shared
+        static Node &ownNode(std::shared_ptr<Node> &node)
+        {
+            if (!node)
+            {
+                node = std::make_shared<Node>();
+            }
+            else if (node.use_count() > 1)
+            {
+                node = std::make_shared<Node>(*node);
+            }
+            return *node;
+        }
+
+        // Turns a full leaf into a branch. Past the last digit of the hash, keys that
+        // collide stay together in one leaf.
+        static void split(Node &leaf, int depth)
+        {
+            if (depth >= MAX_DEPTH)
+            {
+                return;
+            }
+            leaf.branch = true;
+            for (Entry &entry : leaf.entries)
+            {
+                ownNode(leaf.children[digit(std::hash<Key>()(entry.first), depth)]).entries.push_back(std::move(entry));
+            }
+            leaf.entries.clear();
+            for (std::shared_ptr<Node> &child : leaf.children)
+            {
+                if (child && child->entries.size() > LEAF_SIZE)
+                {
+                    split(*child, depth + 1);
+                }
+            }
+        }
+
+        std::shared_ptr<Node> root;
+        size_t count;
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+using std::vector;
+
+// A vector whose copies share storage. Elements live in fixed-size chunks held by
+// shared pointers, and the table of chunks is shared too, so copying is O(1).
+// Writing through mutate or push_back first copies the table and the one chunk written
+// to if another copy still uses them; chunks nobody writes to stay shared.
+// Copies may be read from any thread. Writes need the same care as for std::vector,
+// plus: two copies sharing storage must not be written to at the same time.
+template <typename T>
+class CowVector {
+    public:
+        static const size_t CHUNK_SIZE = 256;
+
+        class const_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T *pointer;
+                typedef const T &reference;
+
+                const_iterator(const CowVector *owner, size_t index) : owner(owner), index(index) {}
+                const T &operator*() const { return (*owner)[index]; }
+                const T *operator->() const { return &(*owner)[index]; }
+                const_iterator &operator++() { ++index; return *this; }
+                const_iterator operator++(int) { const_iterator old(*this); ++index; return old; }
+                bool operator==(const const_iterator &other) const { return index == other.index; }
+                bool operator!=(const const_iterator &other) const { return index != other.index; }
+            private:
+                const CowVector *owner;
+                size_t index;
+        };
+
+        CowVector() : table(), count(0) {}
+        CowVector(const CowVector &other) = default;
+        CowVector(CowVector &&other) noexcept : table(std::move(other.table)), count(other.count)
+        {
+            other.count = 0;
+        }
+        CowVector &operator=(const CowVector &other) = default;
+        CowVector &operator=(CowVector &&other) noexcept
+        {
+            table = std::move(other.table);
+            count = other.count;
+            other.count = 0;
+            return *this;
+        }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        const T &operator[](size_t index) const
+        {
+            return (*(*table)[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+        }
+
+        const T &back() const { return (*this)[count - 1]; }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, count); }
+
+        // Each chunk is contiguous, so scans can run over chunkData(c)[0, chunkLength(c))
+        // for every c below chunkCount(); chunk c starts at element c * CHUNK_SIZE.
+        size_t chunkCount() const { return table ? table->size() : 0; }
+        const T *chunkData(size_t chunkIndex) const { return (*table)[chunkIndex]->data(); }
+        size_t chunkLength(size_t chunkIndex) const { return (*table)[chunkIndex]->size(); }
+
+        // Writable element; copies its chunk first if the chunk is shared.
+        // Do not keep the reference once the vector has been copied.
+        T &mutate(size_t index)
+        {
+            return ownChunk(index / CHUNK_SIZE)[index % CHUNK_SIZE];
+        }
+
+        void push_back(const T &value)
+        {
+            lastChunkWithRoom().push_back(value);
+            count++;
+        }
+
+        void push_back(T &&value)
+        {
+            lastChunkWithRoom().push_back(std::move(value));
+            count++;
+        }
+
+        void pop_back()
+        {
+            Chunk &chunk = ownChunk((count - 1) / CHUNK_SIZE);
+            chunk.pop_back();
+            count--;
+            if (chunk.empty())
+            {
+                table->pop_back();
+            }
+        }
+
+        void clear()
+        {
+            table.reset();
+            count = 0;
+        }
+
+    private:
+        typedef vector<T> Chunk;
+        typedef vector<std::shared_ptr<Chunk>> Table;
+
+        Table &ownTable()
+        {
+            if (!table)
+            {
+                table = std::make_shared<Table>();
+            }
+            else if (table.use_count() > 1)
+            {
+                table = std::make_shared<Table>(*table);
+            }
+            return *table;
+        }
+
+        Chunk &ownChunk(size_t chunkIndex)
+        {
+            std::shared_ptr<Chunk> &chunk = ownTable()[chunkIndex];
+            if (chunk.use_count() > 1)
+            {
+                std::shared_ptr<Chunk> copy = std::make_shared<Chunk>();
+                copy->reserve(CHUNK_SIZE);
+                for (const T &element : *chunk)
+                {
+                    copy->push_back(element);
+                }
+                chunk = copy;
+            }
+            return *chunk;
+        }
+
+        // Chunks never grow past CHUNK_SIZE, so their elements never move
+        Chunk &lastChunkWithRoom()
+        {
+            if (count % CHUNK_SIZE == 0)
+            {
+                std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+                chunk->reserve(CHUNK_SIZE);
+                ownTable().push_back(chunk);
+                return *chunk;
+            }
+            return ownChunk(count / CHUNK_SIZE);
+        }
+
+        std::shared_ptr<Table> table;
+        size_t count;
+};
+
+template <typename T>
+const size_t CowVector<T>::CHUNK_SIZE;
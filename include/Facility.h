@@ -43,6 +43,7 @@ class Facility: public FacilityType {
     public:
         Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score);
         Facility(const FacilityType &type, const string &settlementName);
+        Facility(const FacilityType &type, const string &settlementName, FacilityStatus status, int timeLeft);
         const string &getSettlementName() const;
         const int getTimeLeft() const;
         FacilityStatus step();
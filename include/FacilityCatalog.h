@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "BalanceIndex.h"
+#include "CowMap.h"
+#include "CowVector.h"
+#include "Facility.h"
+using std::string;
+using std::vector;
+
+// The simulation's facility types, in the order they were added, with lookups by name
+// and by category. Entries are only ever appended, so catalog indices stay valid.
+// Every part is stored copy-on-write, so a copy is cheap and adding to it copies only
+// the last chunk of each column and the path to the new entry in each index.
+class FacilityCatalog {
+    public:
+        FacilityCatalog();
+        FacilityCatalog(const FacilityCatalog &other) = default;
+        FacilityCatalog(FacilityCatalog &&other) = default;
+        FacilityCatalog &operator=(const FacilityCatalog &other) = default;
+        FacilityCatalog &operator=(FacilityCatalog &&other) = default;
+        bool add(const FacilityType &facility);
+        bool contains(const string &name) const;
+        size_t size() const;
+        bool empty() const;
+        const FacilityType &operator[](size_t index) const;
+        int indexOf(const FacilityType &facility) const;
+        // Catalog indices of the facilities in a category, in ascending order
+        const CowVector<int> &getCategory(FacilityCategory category) const;
+        // Score columns, one entry per catalog index, for scans over the whole catalog
+        const CowVector<int> &getLifeQualityScores() const;
+        const CowVector<int> &getEconomyScores() const;
+        const CowVector<int> &getEnvironmentScores() const;
+        const BalanceIndex &getBalanceIndex() const;
+        // Changes whenever the catalog does; copies share their original's version
+        unsigned long long getVersion() const;
+        CowVector<FacilityType>::const_iterator begin() const;
+        CowVector<FacilityType>::const_iterator end() const;
+        void clear();
+
+    private:
+        CowVector<FacilityType> facilities;
+        CowMap<string, int> nameIndex;
+        CowVector<int> byCategory[3];
+        CowVector<int> lifeQualityScores;
+        CowVector<int> economyScores;
+        CowVector<int> environmentScores;
+        BalanceIndex balanceIndex;
+        unsigned long long version;
+};
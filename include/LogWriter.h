@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+using std::string;
+
+// When the log file is synced to disk
+enum class FsyncPolicy {
+    NEVER,  // Left to the operating system
+    BATCH,  // After each batch of lines the writer thread picks up
+    ALWAYS, // After each line
+};
+
+// Appends lines to a file from a background thread. submit only hands the line over,
+// through a single-producer single-consumer ring, so the thread running commands never
+// waits for the disk. If the ring is full, lines wait in a backlog of the submitting
+// thread and go into the ring on later submits. submit must always be called from the
+// same thread. The destructor writes everything still pending.
+class LogWriter {
+    public:
+        // Throws if the file cannot be opened
+        LogWriter(const string &path, FsyncPolicy fsyncPolicy);
+        LogWriter(const LogWriter &other) = delete;
+        LogWriter &operator=(const LogWriter &other) = delete;
+        ~LogWriter();
+        void submit(string line);
+
+        // Process-wide writer for the action log, set up from the command line.
+        // Without configure there is none and shared returns nullptr.
+        static void configure(const string &path, FsyncPolicy fsyncPolicy);
+        static LogWriter *shared();
+
+    private:
+        static const size_t CAPACITY = 4096;
+
+        bool tryPush(string &line);
+        void wake();
+        void writerLoop();
+        void writeAll(const string &data);
+
+        int fd;
+        FsyncPolicy fsyncPolicy;
+        std::unique_ptr<string[]> slots;
+        std::atomic<size_t> head; // Next slot the writer reads
+        std::atomic<size_t> tail; // Next slot submit fills
+        std::deque<string> backlog; // Lines that did not fit, oldest first
+        std::atomic<bool> sleeping;
+        std::atomic<bool> stopping;
+        std::mutex mutex; // Only for sleeping and waking the writer
+        std::condition_variable wakeCv;
+        std::thread writer; // Last, so it starts once the rest is ready
+};
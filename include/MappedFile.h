@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <string>
+using std::string;
+
+// Read-only view of a whole file, unmapped on destruction
+class MappedFile {
+    public:
+        // kind names the file in errors, e.g. "config file"
+        MappedFile(const string &path, const string &kind);
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile &operator=(const MappedFile &other) = delete;
+        ~MappedFile();
+        const char *getData() const;
+        size_t getSize() const;
+
+    private:
+        const char *data;
+        size_t size;
+};
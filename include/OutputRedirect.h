@@ -0,0 +1,15 @@
+#pragma once
+#include <iostream>
+
+// Sends std::cout to the capture stream, or nowhere, while in scope
+class OutputRedirect {
+    public:
+        explicit OutputRedirect(std::ostream *capture)
+            : previous(std::cout.rdbuf(capture != nullptr ? capture->rdbuf() : nullptr)) {}
+        OutputRedirect(const OutputRedirect &other) = delete;
+        OutputRedirect &operator=(const OutputRedirect &other) = delete;
+        ~OutputRedirect() { std::cout.rdbuf(previous); }
+
+    private:
+        std::streambuf *previous;
+};
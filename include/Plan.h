@@ -1,8 +1,11 @@
 #pragma once
+#include <memory>
 #include <vector>
+#include <unordered_map>
 #include "Facility.h"
 #include "Settlement.h"
-#include "SelectionPolicy.h"
+#include "PolicyVariant.h"
+#include "StateHash.h"
 using std::vector;
 
 enum class PlanStatus {
@@ -10,40 +13,84 @@ enum class PlanStatus {
     BUSY,
 };
 
+// A plan refers to no other part of its simulation but its settlement, which never
+// changes, so snapshots of a simulation can share plans. The catalog is passed in
+// by whoever steps or prints the plan.
 class Plan {
     public:
-        Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
+        Plan(const int planId, std::shared_ptr<const Settlement> settlement, int policyId, long long clock = 0);
         const int getlifeQualityScore() const;
         const int getEconomyScore() const;
         const int getEnvironmentScore() const;
-        void setSelectionPolicy(SelectionPolicy *selectionPolicy);
-        void step();
-        void printStatus();
-        const vector<Facility*> &getFacilities() const;
-        void addFacility(Facility* facility);
+        // Starts a fresh policy of the given registry id. Score-aware policies start from
+        // the plan's scores including the facilities still under construction.
+        void setSelectionPolicy(int policyId, const FacilityCatalog &facilityOptions);
+        void step(const FacilityCatalog &facilityOptions);
+        void advanceTo(long long targetStep, const FacilityCatalog &facilityOptions);
+        void catchUp(long long currentStep);
+        long long nextEventStep() const;
+        long long getClock() const;
+        void printStatus() const;
+        vector<Facility> getFacilities(const FacilityCatalog &facilityOptions) const;
         const string toString() const;
+        // Adds what the plan shows to the outside; call catchUp first
+        void addToHash(StateHash &hash) const;
         const int getID() const;
         Plan(const Plan& other);                          // Copy constructor
         Plan& operator=(const Plan& other) = delete;               // Copy assignment operator
         Plan(Plan&& other) noexcept;                      // Move constructor
         Plan& operator=(Plan&& other) noexcept = delete;           // Move assignment operator
-        ~Plan();   
-        const vector<Facility*> &getConstruction() const;
-        const string getSelectionPolicy() const;
+        ~Plan();
+        // Time left is given as of currentStep, which may be past the plan's clock
+        vector<Facility> getConstruction(const FacilityCatalog &facilityOptions, long long currentStep) const;
+        int getPolicyId() const;
+        const string &getSelectionPolicy() const; // Short name, e.g. "nve"
 
         //RABIN SHIT
 
-        SelectionPolicy *getPolicy() const;
+        const SelectionPolicy *getPolicy() const;
         const string &getSettlement() const;
-        Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions, int life_quality_score, int economy_score, int environment_score, vector<Facility *> facilities, vector<Facility *> underConstruction);
 
     private:
+        friend class SimulationImage;
+        struct PeriodMark {
+            long long clock;
+            int life_quality_score, economy_score, environment_score;
+            size_t completed;
+        };
+        // A run of completions that happened `repeats` times over, one after another
+        struct CompletionBlock {
+            CompletionBlock() : types(), repeats(1) {}
+            CompletionBlock(const vector<int> &types, int repeats) : types(types), repeats(repeats) {}
+            vector<int> types;
+            int repeats;
+        };
+        // One instantiation per built-in policy, so its selection is called directly
+        template <typename Policy> void stepWith(Policy &policy, const FacilityCatalog &facilityOptions);
+        template <typename Policy> void advanceWith(Policy &policy, long long targetStep, const FacilityCatalog &facilityOptions);
+        bool skipPeriods(int position, std::unordered_map<string, PeriodMark> &seen, long long targetStep);
+        void addConstructionTimes(size_t first, const FacilityCatalog &facilityOptions);
+        void finishStep(const FacilityCatalog &facilityOptions);
+        long long nextCompletionStep() const;
+        void countDown(int steps);
+        void completeConstruction(size_t index, const FacilityCatalog &facilityOptions);
+
         int plan_id;
-        const Settlement &settlement;
-        SelectionPolicy *selectionPolicy; //What happens if we change this to a reference?
+        std::shared_ptr<const Settlement> settlement;
+        int policyId;                       // Registry id of selectionPolicy
+        PolicyVariant selectionPolicy;
         PlanStatus status;
-        vector<Facility*> facilities;
-        vector<Facility*> underConstruction;
-        const vector<FacilityType> &facilityOptions;
+        // Facilities are kept as columns of catalog indices; Facility objects are only
+        // built when a plan is printed. Status is given by which columns a facility is in.
+        // Operational facilities never change again, so they are kept as a count per type
+        // and, for printing, as catalog indices in completion order.
+        vector<int> operationalCounts;      // Indexed by catalog index, grows with the catalog
+        // A period skipped by skipPeriods is one block, so cyclic plans keep this short
+        vector<CompletionBlock> completionOrder;
+        vector<int> constructionTypes;      // Under construction
+        vector<int> constructionTimeLeft;   // Steps left for each entry of constructionTypes
         int life_quality_score, economy_score, environment_score;
+        long long clock; // Last simulation step this plan's timers are accurate for
+        bool recordCompletions;             // Set while advanceTo looks for a period
+        vector<int> recentCompletions;      // Catalog indices completed while recording
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PolicyVariant.h"
+using std::string;
+using std::vector;
+
+// Selection policies known to the simulation, by id. Plans and actions keep the id and
+// only turn it into a name for output. The built-in policies are registered first, with
+// the fixed ids below; registerPolicy adds more without touching the command handling.
+class PolicyRegistry {
+    public:
+        static const int NAIVE = 0;
+        static const int BALANCED = 1;
+        static const int ECONOMY = 2;
+        static const int SUSTAINABILITY = 3;
+        static const int HORIZON = 4;
+
+        // Builds a policy for a plan whose scores, counting facilities still under
+        // construction, are the given ones. Only score-aware policies use them.
+        typedef PolicyVariant (*Factory)(int lifeQualityScore, int economyScore, int environmentScore);
+
+        // Returns the new policy's id. Throws if the short name is taken.
+        static int registerPolicy(const string &shortName, const string &longName, Factory factory);
+        // Id of the policy with this short name, or -1
+        static int find(const string &shortName);
+        static bool isValid(int id);
+        static const string &getShortName(int id);
+        static const string &getLongName(int id);
+        static PolicyVariant create(int id, int lifeQualityScore, int economyScore, int environmentScore);
+
+    private:
+        struct Entry {
+            string shortName;
+            string longName;
+            Factory factory;
+        };
+        struct Table {
+            Table();
+            vector<Entry> entries;
+            std::unordered_map<string, int> byShortName;
+        };
+        static Table &table();
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "SelectionPolicy.h"
+
+// A plan's selection policy, held by value. The built-in policies are stored inline
+// and called through their concrete (final) types, so picking a facility is a direct call
+// and changing a plan's policy allocates nothing. Any other SelectionPolicy is owned
+// through a pointer and called virtually.
+class PolicyVariant {
+    public:
+        enum class Kind { NAIVE, BALANCED, ECONOMY, SUSTAINABILITY, HORIZON, CUSTOM };
+
+        PolicyVariant(const NaiveSelection &policy);
+        PolicyVariant(const BalancedSelection &policy);
+        PolicyVariant(const EconomySelection &policy);
+        PolicyVariant(const SustainabilitySelection &policy);
+        PolicyVariant(const HorizonSelection &policy);
+        // Takes ownership. A built-in policy is copied inline and the pointer deleted.
+        explicit PolicyVariant(SelectionPolicy *policy);
+        PolicyVariant(const PolicyVariant &other);
+        PolicyVariant(PolicyVariant &&other) noexcept;
+        PolicyVariant &operator=(const PolicyVariant &other);
+        PolicyVariant &operator=(PolicyVariant &&other) noexcept;
+        ~PolicyVariant();
+
+        Kind getKind() const { return kind; }
+        SelectionPolicy &get();
+        const SelectionPolicy &get() const;
+
+        // Only valid for the matching kind
+        NaiveSelection &asNaive() { return naive; }
+        BalancedSelection &asBalanced() { return balanced; }
+        EconomySelection &asEconomy() { return economy; }
+        SustainabilitySelection &asSustainability() { return sustainability; }
+        HorizonSelection &asHorizon() { return horizon; }
+        SelectionPolicy &asCustom() { return *custom; }
+
+    private:
+        void copyFrom(const PolicyVariant &other);
+        void destroy();
+
+        Kind kind;
+        union {
+            NaiveSelection naive;
+            BalancedSelection balanced;
+            EconomySelection economy;
+            SustainabilitySelection sustainability;
+            HorizonSelection horizon;
+            SelectionPolicy *custom;
+        };
+};
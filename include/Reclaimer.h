@@ -0,0 +1,31 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+
+// Destroys objects on a background thread, so that dropping a large state (such as
+// the simulation a restore replaces) does not hold up the command that dropped it.
+// Objects still pending when the reclaimer is destroyed are destroyed then.
+class Reclaimer {
+    public:
+        Reclaimer();
+        Reclaimer(const Reclaimer &other) = delete;
+        Reclaimer &operator=(const Reclaimer &other) = delete;
+        ~Reclaimer();
+        // Drops this reference to object in the background
+        void release(std::shared_ptr<void> object);
+
+        static Reclaimer &shared();
+
+    private:
+        void workerLoop();
+
+        std::mutex mutex;
+        std::condition_variable wakeCv;
+        vector<std::shared_ptr<void>> pending;
+        bool stopping;
+        std::thread worker; // Last, so it starts once the rest is ready
+};
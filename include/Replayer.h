@@ -0,0 +1,58 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+class ActionLog;
+class BaseAction;
+class Simulation;
+enum class ActionStatus;
+
+struct ReplayReport {
+    ReplayReport();
+    size_t actions;                  // Actions applied
+    size_t skipped;                  // Lines that are not actions
+    double seconds;
+    unsigned long long stateHash;    // Simulation::stateHash after the replay
+    long long firstDivergence;       // Index of the first action whose status differs from the recorded one, or -1
+    string divergence;               // What differed there
+    bool hasExpectedHash;
+    unsigned long long expectedHash; // State hash the replay should end with, when known
+};
+
+// Applies a recorded stream of actions to a simulation, as if typed into it after start
+// but without parsing them through actionHandler. What the actions print is dropped, or
+// written to the capture stream. A stream is one of:
+//   - a text file of commands, as typed, or of logged actions as --log-file writes them
+//     ("<action> COMPLETED" / "<action> ERROR: <message>") or as log prints them
+//   - a snapshot file, whose action log is replayed and whose state is the expected end state
+//   - an ActionLog, for instance another simulation's
+// Restore, undo and load are applied from text but not from logs: in a log, what comes
+// before their entry is already the history of the state they went to.
+// Undo from text needs an undo journal; with --undo off, one is kept while replaying.
+// Logged statuses are compared with the statuses the replayed actions end with. The
+// stream ends at the first close. Save actions are logged but do not write files; backups
+// go to the process-wide backup and snapshots like any others.
+class Replayer {
+    public:
+        explicit Replayer(Simulation &simulation);
+        void setCapture(std::ostream *capture); // nullptr (the default) drops output
+        ReplayReport replayFile(const string &path);
+        ReplayReport replayLog(const ActionLog &log);
+
+        // Parses one line in any of the text forms; nullptr if it is not an action.
+        // hasStatus and status tell whether the line carried a logged status and which.
+        static BaseAction *parse(const string &line, bool &hasStatus, ActionStatus &status);
+        static void printReport(const ReplayReport &report, std::ostream &out);
+
+    private:
+        // Applies the action; false once it is a close
+        bool apply(BaseAction &action, bool hasStatus, ActionStatus status, ReplayReport &report);
+        void replayText(const char *data, size_t size, ReplayReport &report);
+        void replayRecords(const ActionLog &log, ReplayReport &report);
+
+        Simulation &simulation;
+        std::ostream *capture;
+};
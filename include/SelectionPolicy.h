@@ -1,61 +1,119 @@
 #pragma once
 #include <vector>
-#include "Facility.h"
+#include "FacilityCatalog.h"
 using std::vector;
 using namespace std;
 
 class SelectionPolicy {
     public:
-        virtual const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) = 0;
+        virtual const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) = 0;
+        // Appends the catalog indices of the next count picks to selected, the same
+        // ones count calls to selectFacility would return unless the policy says otherwise
+        virtual void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected);
         virtual const string toString() const = 0;
         virtual SelectionPolicy* clone() const = 0;
+        // Policies that walk the catalog in a fixed cycle report where they are in it,
+        // which is all their state. Others return false.
+        virtual bool cyclePosition(int &position) const { return false; }
+        // The policy's state as integers, for snapshot files. Policies without state
+        // save nothing; restoreState throws if given a state it cannot have saved.
+        virtual void saveState(vector<int> &state) const {}
+        virtual void restoreState(const vector<int> &state);
         virtual ~SelectionPolicy() = default;
 };
 
-class NaiveSelection: public SelectionPolicy {
+class NaiveSelection final: public SelectionPolicy {
     public:
         NaiveSelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) override;
         const string toString() const override;
         NaiveSelection *clone() const override;
+        bool cyclePosition(int &position) const override;
+        void saveState(vector<int> &state) const override;
+        void restoreState(const vector<int> &state) override;
         ~NaiveSelection() override = default;
     private:
         int lastSelectedIndex;
 };
 
-class BalancedSelection: public SelectionPolicy {
+class BalancedSelection final: public SelectionPolicy {
     public:
         BalancedSelection();
         BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) override;
         const string toString() const override;
         BalancedSelection *clone() const override;
+        void saveState(vector<int> &state) const override;
+        void restoreState(const vector<int> &state) override;
         ~BalancedSelection() override = default;
     private:
+        int selectIndex(const FacilityCatalog& facilitiesOptions);
+
         int LifeQualityScore;
         int EconomyScore;
         int EnvironmentScore;
 };
 
-class EconomySelection: public SelectionPolicy {
+class EconomySelection final: public SelectionPolicy {
     public:
         EconomySelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) override;
         const string toString() const override;
         EconomySelection *clone() const override;
+        bool cyclePosition(int &position) const override;
+        void saveState(vector<int> &state) const override;
+        void restoreState(const vector<int> &state) override;
         ~EconomySelection() override = default;
     private:
-        int lastSelectedIndex;
+        int lastSelectedIndex; // Position in the catalog's list of economy facilities
 
 };
 
-class SustainabilitySelection: public SelectionPolicy {
+class SustainabilitySelection final: public SelectionPolicy {
     public:
         SustainabilitySelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) override;
         const string toString() const override;
         SustainabilitySelection *clone() const override;
+        bool cyclePosition(int &position) const override;
+        void saveState(vector<int> &state) const override;
+        void restoreState(const vector<int> &state) override;
         ~SustainabilitySelection() override = default;
     private:
-        int lastSelectedIndex;
+        int lastSelectedIndex; // Position in the catalog's list of environment facilities
+};
+
+// Looks ahead instead of picking greedily. The free construction slots are planned
+// together as sequences of builds, searching for the builds whose totals, added to the
+// plan's, have the best weighted score less spread among the builds finishing within
+// the horizon. The picks are the first build of each slot. Like BalancedSelection it
+// keeps the plan's totals, counting facilities under construction. Searches are shared
+// by all plans that make the same one.
+class HorizonSelection final: public SelectionPolicy {
+    public:
+        HorizonSelection();
+        HorizonSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        // Plans the count slots together, so the picks can differ from count single calls
+        void selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) override;
+        const string toString() const override;
+        HorizonSelection *clone() const override;
+        void saveState(vector<int> &state) const override;
+        void restoreState(const vector<int> &state) override;
+        ~HorizonSelection() override = default;
+        // Settings for policies created from now on
+        static void configure(int horizon, int lifeQualityWeight, int economyWeight, int environmentWeight);
+    private:
+        vector<int> search(const FacilityCatalog& facilitiesOptions, int count) const;
+        int horizon;
+        int lifeQualityWeight;
+        int economyWeight;
+        int environmentWeight;
+        int LifeQualityScore;
+        int EconomyScore;
+        int EnvironmentScore;
 };
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
+#include "ActionLog.h"
+#include "CowMap.h"
+#include "CowVector.h"
 #include "Facility.h"
+#include "FacilityCatalog.h"
 #include "Plan.h"
 #include "Settlement.h"
 
@@ -9,20 +14,27 @@ using std::string;
 using std::vector;
 
 class BaseAction;
-class SelectionPolicy;
 
+// Copying a simulation is O(1): every part of its state is shared with the copy and
+// copied again, chunk by chunk, only when one of them changes it (see CowVector).
 class Simulation {
     public:
         Simulation(const string &configFilePath);
         void start();
-        void addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
-        void addAction(BaseAction *action);
+        void addPlan(const Settlement &settlement, int policyId);
+        void addAction(const BaseAction &action);
+        void addAction(BaseAction *action); // Takes ownership
         bool addSettlement(Settlement *settlement);
         bool addFacility(FacilityType facility);
         bool isSettlementExists(const string &settlementName);
-        Settlement &getSettlement(const string &settlementName);
+        const Settlement &getSettlement(const string &settlementName);
+        // Both throw if there is no plan with this ID. The first brings the plan's timers
+        // up to date; the second leaves shared plans shared, and its timers may lag behind
+        // getCurrentStep().
         Plan &getPlan(const int planID);
+        const Plan &getPlan(const int planID) const;
         void step();
+        void step(int numOfSteps);
         void close();
         void open();
         ~Simulation();
@@ -31,18 +43,33 @@ class Simulation {
         Simulation& operator=(const Simulation& other);
         Simulation& operator=(Simulation&& other) noexcept;
         int &getplanCounter();
-        vector<FacilityType> &getFacilitiesOptions();
-        const vector<BaseAction*> &getActionsLog(); 
-        vector<Settlement*> &getSettlements();
+        const FacilityCatalog &getFacilitiesOptions() const;
+        const ActionLog &getActionsLog() const;
         void printLog() const;
         void actionHandler(const std::string &action);
+        long long getCurrentStep() const;
+        // Hash of the settlements, catalog, plans and counters, but not of the log.
+        // Equal states hash equally however far each plan has been caught up.
+        unsigned long long stateHash() const;
+        // Runs an action and logs it as actionHandler would, undo journal included
+        void perform(BaseAction &action);
 
     private:
+        friend class SimulationImage;
+        friend class Replayer;
+        friend class Benchmark;
+        void scheduleWake(int planIndex);
+        void runUndoable(BaseAction &action);
+
         bool isRunning;
         //int settleCounter;
         int planCounter; //For assigning unique plan IDs
-        vector<BaseAction*> actionsLog;
-        vector<Settlement*> settlements;
-        vector<FacilityType> facilitiesOptions;
-        vector<Plan> plans;
+        ActionLog actionsLog;
+        CowVector<std::shared_ptr<const Settlement>> settlements;
+        // Copied when added to while shared; the copy shares the catalog's chunks
+        std::shared_ptr<FacilityCatalog> facilitiesOptions;
+        CowMap<string, int> settlementIndex; // Settlement name -> position in settlements
+        CowVector<Plan> plans;
+        long long currentStep; // Steps simulated so far
+        CowVector<std::pair<long long, int>> calendar; // Min-heap of (next event step, plan index)
 };
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+using std::string;
+
+class Simulation;
+
+// Binary snapshot files. A file is a fixed header followed by a payload:
+//   header:  magic "SIMIMAGE", format version, byte order mark, payload size and an
+//            FNV-1a checksum of the payload
+//   payload: string table, simulation counters, settlements, catalog (one column per
+//            field), plans (with their facilities and policy state) and the action log
+// Strings are stored once in the table and referred to by index, and plans refer to
+// their settlement by index. A config compiled with --compile-config is a snapshot of
+// the state the config sets up, and can be given instead of the config file. Numbers are fixed-width
+// in the byte order of the machine that wrote the file, which load checks.
+class SimulationImage {
+    public:
+        static void save(const Simulation &simulation, const string &path);
+        // Replaces the simulation's state with the file's. The file is mapped, not read,
+        // and the simulation is left unchanged if the file is rejected.
+        static void load(Simulation &simulation, const string &path);
+        // Whether data, the start of a file, looks like a snapshot file
+        static bool isImage(const string &data);
+};
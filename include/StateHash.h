@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+using std::string;
+
+// FNV-1a hash of a sequence of values, for comparing simulation states
+class StateHash {
+    public:
+        StateHash() : hash(14695981039346656037ULL) {}
+
+        void add(long long value)
+        {
+            unsigned long long bits = static_cast<unsigned long long>(value);
+            for (int i = 0; i < 8; i++)
+            {
+                addByte(static_cast<unsigned char>(bits >> (8 * i)));
+            }
+        }
+
+        // Length first, so that consecutive strings cannot run into each other
+        void add(const string &value)
+        {
+            add(static_cast<long long>(value.size()));
+            for (char c : value)
+            {
+                addByte(static_cast<unsigned char>(c));
+            }
+        }
+
+        unsigned long long get() const { return hash; }
+
+    private:
+        void addByte(unsigned char byte)
+        {
+            hash = (hash ^ byte) * 1099511628211ULL;
+        }
+
+        unsigned long long hash;
+};
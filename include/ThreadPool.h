@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+
+// Persistent worker pool used to split index ranges (e.g. plans) across threads.
+// The calling thread takes part in every job, so a pool of N threads runs N-1 workers.
+class ThreadPool {
+    public:
+        explicit ThreadPool(int threadCount);
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool &operator=(const ThreadPool &other) = delete;
+        ~ThreadPool();
+        int getThreadCount() const;
+        // Runs body(begin, end) over chunks of [0, count). Idle threads steal chunks from busy ones.
+        void parallelFor(size_t count, const std::function<void(size_t, size_t)> &body);
+
+        // Process-wide pool, sized once from the command line (0 = one thread per core)
+        static void configure(int threadCount);
+        static ThreadPool &shared();
+
+    private:
+        struct Range {
+            Range();
+            std::atomic<size_t> next;
+            size_t end;
+        };
+
+        void workerLoop(int self);
+        void runChunks(int self);
+        bool claimChunk(int owner, size_t &chunk);
+
+        int threadCount;
+        vector<std::thread> workers;
+        std::unique_ptr<Range[]> ranges;
+        std::mutex mutex;
+        std::condition_variable wakeCv;
+        std::condition_variable doneCv;
+        unsigned long generation;
+        int pending;
+        bool stopping;
+        const std::function<void(size_t, size_t)> *body;
+        size_t count;
+        size_t grain;
+        std::exception_ptr failure;
+};
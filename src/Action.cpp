@@ -1,13 +1,20 @@
+#include <deque>
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
+#include <stdexcept>
 #include "Simulation.h"
-#include "SelectionPolicy.h"
+#include "PolicyRegistry.h"
+#include "Reclaimer.h"
+#include "SimulationImage.h"
 #include "Action.h"
 
 using namespace std;
 
 extern Simulation *backup;
+extern std::map<string, Simulation> snapshots;
+extern std::deque<Simulation> undoJournal;
 
 // BaseAction Implementation
 
@@ -30,11 +37,103 @@ void BaseAction::error(string errorMsg)
     cout << "Error: " << errorMsg << endl;
 }
 
+void BaseAction::setStatus(ActionStatus status)
+{
+    this->status = status;
+}
+
 const string &BaseAction::getErrorMsg() const
 {
     return errorMsg;
 }
 
+bool BaseAction::changesState() const
+{
+    return false;
+}
+
+BaseAction *BaseAction::decode(ActionLog::Reader &reader, ActionStatus status)
+{
+    BaseAction *action = nullptr;
+    switch (static_cast<ActionCode>(reader.readByte()))
+    {
+    case ActionCode::STEP:
+        action = new SimulateStep(reader.readInt());
+        break;
+    case ActionCode::ADD_PLAN:
+    {
+        const string &settlementName = reader.readString();
+        action = new AddPlan(settlementName, reader.readString());
+        break;
+    }
+    case ActionCode::ADD_SETTLEMENT:
+    {
+        const string &settlementName = reader.readString();
+        unsigned char type = reader.readByte();
+        if (type > static_cast<unsigned char>(SettlementType::METROPOLIS))
+            throw std::runtime_error("Action log is corrupt");
+        action = new AddSettlement(settlementName, static_cast<SettlementType>(type));
+        break;
+    }
+    case ActionCode::ADD_FACILITY:
+    {
+        const string &facilityName = reader.readString();
+        unsigned char category = reader.readByte();
+        if (category > static_cast<unsigned char>(FacilityCategory::ENVIRONMENT))
+            throw std::runtime_error("Action log is corrupt");
+        int price = reader.readInt();
+        int lifeQualityScore = reader.readInt();
+        int economyScore = reader.readInt();
+        int environmentScore = reader.readInt();
+        action = new AddFacility(facilityName, static_cast<FacilityCategory>(category), price, lifeQualityScore, economyScore, environmentScore);
+        break;
+    }
+    case ActionCode::PLAN_STATUS:
+        action = new PrintPlanStatus(reader.readInt());
+        break;
+    case ActionCode::CHANGE_POLICY:
+    {
+        int planId = reader.readInt();
+        action = new ChangePlanPolicy(planId, reader.readString());
+        break;
+    }
+    case ActionCode::PRINT_LOG:
+        action = new PrintActionsLog();
+        break;
+    case ActionCode::CLOSE:
+        action = new Close();
+        break;
+    case ActionCode::BACKUP:
+        action = new BackupSimulation(reader.readString());
+        break;
+    case ActionCode::RESTORE:
+        action = new RestoreSimulation(reader.readString());
+        break;
+    case ActionCode::SNAPSHOTS:
+        action = new PrintSnapshots();
+        break;
+    case ActionCode::DROP_SNAPSHOT:
+        action = new DropSnapshot(reader.readString());
+        break;
+    case ActionCode::UNDO:
+        action = new Undo(reader.readInt());
+        break;
+    case ActionCode::SAVE:
+        action = new SaveSimulation(reader.readString());
+        break;
+    case ActionCode::LOAD:
+        action = new LoadSimulation(reader.readString());
+        break;
+    case ActionCode::RECORDED:
+        action = new RecordedAction(reader.readString(), status);
+        break;
+    default:
+        throw std::runtime_error("Action log is corrupt");
+    }
+    action->setStatus(status);
+    return action;
+}
+
 
 // SimulateStep Implementation
     SimulateStep::SimulateStep(const int numOfSteps) : BaseAction(), numOfSteps(numOfSteps) {}
@@ -42,9 +141,14 @@ const string &BaseAction::getErrorMsg() const
     void SimulateStep::act(Simulation &simulation)
     {
         // Simulation logic to step forward
-        for (int i = 0; i < numOfSteps; ++i)
+        try
+        {
+            simulation.step(numOfSteps);
+        }
+        catch (const std::runtime_error &e)
         {
-            simulation.step();
+            error(e.what());
+            return;
         }
         complete();
     }
@@ -54,6 +158,17 @@ const string &BaseAction::getErrorMsg() const
         return "SimulateStep " + to_string(numOfSteps);
     }
 
+    void SimulateStep::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::STEP);
+        log.writeInt(numOfSteps);
+    }
+
+    bool SimulateStep::changesState() const
+    {
+        return true;
+    }
+
     SimulateStep *SimulateStep::clone() const
     {
         return new SimulateStep(*this);
@@ -67,48 +182,23 @@ const string &BaseAction::getErrorMsg() const
     void AddPlan::act(Simulation &simulation)
     {
         // Check if the settlement exists and if the policy is valid
+        int policyId = PolicyRegistry::find(selectionPolicy);
         if (!simulation.isSettlementExists(settlementName))
         {
             error("Cannot create this plan: Settlement does not exist.");
             return;
         }
 
-        else if (selectionPolicy != "env" && selectionPolicy != "eco" &&
-            selectionPolicy != "bal" && selectionPolicy != "nve")
+        else if (policyId < 0)
         {
             error("Cannot create this plan: Invalid selection policy.");
             return;
         }
         else
         {
-// Create the appropriate selection policy
-        SelectionPolicy *policy = nullptr;
-        if (selectionPolicy == "nve")
-        {
-            policy = new NaiveSelection();
-        }
-        else if (selectionPolicy == "bal")
-        {
-            policy = new BalancedSelection(0, 0, 0);
-        }
-        else if (selectionPolicy == "eco")
-        {
-            policy = new EconomySelection();
-        }
-        else if (selectionPolicy == "env")
-        {
-            policy = new SustainabilitySelection();
-        }
-        else{
-            error("Couldn't access any type");
-        }
-
         // Add the plan to the simulation
-        if (policy)
-        {
-            simulation.addPlan(simulation.getSettlement(settlementName), policy);
-            complete();
-        }
+        simulation.addPlan(simulation.getSettlement(settlementName), policyId);
+        complete();
     }
         
     }
@@ -117,6 +207,18 @@ const string &BaseAction::getErrorMsg() const
         return "Plan " + settlementName + " " + selectionPolicy;
     }
 
+    void AddPlan::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::ADD_PLAN);
+        log.writeString(settlementName);
+        log.writeString(selectionPolicy);
+    }
+
+    bool AddPlan::changesState() const
+    {
+        return true;
+    }
+
     AddPlan *AddPlan::clone() const 
     {
         return new AddPlan(*this);
@@ -160,6 +262,18 @@ const string &BaseAction::getErrorMsg() const
         return "Settlement " + settlementName + " " + categoryStr; 
     }
 
+    void AddSettlement::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::ADD_SETTLEMENT);
+        log.writeString(settlementName);
+        log.writeByte(static_cast<unsigned char>(settlementType));
+    }
+
+    bool AddSettlement::changesState() const
+    {
+        return true;
+    }
+
     AddSettlement *AddSettlement::clone() const 
     {
         return new AddSettlement(*this);
@@ -205,6 +319,22 @@ const string &BaseAction::getErrorMsg() const
            to_string(economyScore) + " " +
            to_string(environmentScore);    }
 
+    void AddFacility::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::ADD_FACILITY);
+        log.writeString(facilityName);
+        log.writeByte(static_cast<unsigned char>(facilityCategory));
+        log.writeInt(price);
+        log.writeInt(lifeQualityScore);
+        log.writeInt(economyScore);
+        log.writeInt(environmentScore);
+    }
+
+    bool AddFacility::changesState() const
+    {
+        return true;
+    }
+
     AddFacility *AddFacility::clone() const
     {
         return new AddFacility(*this);
@@ -219,17 +349,19 @@ const string &BaseAction::getErrorMsg() const
         }
         else
         {
-        Plan currPlan = simulation.getPlan(planId);
+        // Read through a const reference, so printing does not unshare the plan from snapshots
+        const Simulation &reader = simulation;
+        const Plan &currPlan = reader.getPlan(planId);
         currPlan.printStatus();
         string result = "";
 
             // Print all facilities
-        for (const Facility* facility : currPlan.getFacilities()) {
-            result += facility->toString() + "\n";
+        for (const Facility &facility : currPlan.getFacilities(simulation.getFacilitiesOptions())) {
+            result += facility.toString() + "\n";
         }
 
-        for (const Facility* facility : currPlan.getConstruction()) {
-            result += facility->toString() + "\n";
+        for (const Facility &facility : currPlan.getConstruction(simulation.getFacilitiesOptions(), simulation.getCurrentStep())) {
+            result += facility.toString() + "\n";
          }   
         std::cout << result;
         complete(); 
@@ -244,42 +376,23 @@ const string &BaseAction::getErrorMsg() const
         return "PlanStatus " + to_string(planId);
     }
 
+    void PrintPlanStatus::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::PLAN_STATUS);
+        log.writeInt(planId);
+    }
+
     ChangePlanPolicy::ChangePlanPolicy(const int planId, const std::string &newPolicy) : BaseAction(), planId(planId), newPolicy(newPolicy) {}
     void ChangePlanPolicy::act(Simulation &simulation)
     {
-        if(planId < 0 || planId >= simulation.getplanCounter() || newPolicy == simulation.getPlan(planId).getSelectionPolicy())
+        int policyId = PolicyRegistry::find(newPolicy);
+        if(planId < 0 || planId >= simulation.getplanCounter() || policyId == simulation.getPlan(planId).getPolicyId())
             error("Cannot change selection policy");
         else{
-            if (newPolicy == "nve")
-            {
-                NaiveSelection *ns = new NaiveSelection();
-                simulation.getPlan(planId).setSelectionPolicy(ns);
-            }
-            else if (newPolicy == "bal")
+            // An unknown policy name leaves the plan as it is
+            if (policyId >= 0)
             {
-                Plan currPlan = simulation.getPlan(planId);
-                int lif_score_tmp = currPlan.getlifeQualityScore(); 
-                int env_score_tmp = currPlan.getEnvironmentScore(); 
-                int eco_score_tmp = currPlan.getEconomyScore();
-
-                for(Facility *facil : simulation.getPlan(planId).getConstruction())
-                {
-                    lif_score_tmp += facil->getLifeQualityScore();
-                    env_score_tmp += facil->getEnvironmentScore();
-                    eco_score_tmp += facil->getEconomyScore();
-                }
-                BalancedSelection *bs = new BalancedSelection(lif_score_tmp, eco_score_tmp, env_score_tmp);
-                simulation.getPlan(planId).setSelectionPolicy(bs);
-            }
-            else if (newPolicy == "eco")
-            {
-                EconomySelection *es = new EconomySelection();
-                simulation.getPlan(planId).setSelectionPolicy(es);
-            }
-            else if (newPolicy == "env")
-            {
-                SustainabilitySelection *ss = new SustainabilitySelection();
-                simulation.getPlan(planId).setSelectionPolicy(ss);
+                simulation.getPlan(planId).setSelectionPolicy(policyId, simulation.getFacilitiesOptions());
             }
             complete();
         }
@@ -293,29 +406,39 @@ const string &BaseAction::getErrorMsg() const
         return "changePolicy " + to_string(planId) + " " + newPolicy;
     }
 
+    void ChangePlanPolicy::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::CHANGE_POLICY);
+        log.writeInt(planId);
+        log.writeString(newPolicy);
+    }
+
+    bool ChangePlanPolicy::changesState() const
+    {
+        return true;
+    }
+
 // PrintActionsLog Implementation
 
     PrintActionsLog::PrintActionsLog() : BaseAction() {}
 
     void PrintActionsLog::act(Simulation &simulation)
     {
-        vector<BaseAction *> actionsLog = simulation.getActionsLog();
-        for (BaseAction *action : actionsLog)
+        ActionLog::Reader reader(simulation.getActionsLog());
+        while (!reader.atEnd())
         {
-            if (action != this)
+            std::unique_ptr<BaseAction> action = reader.next();
+            std::cout << action->toString() << " ";
+            switch (action->getStatus())
             {
-                std::cout << action->toString() << " ";
-                switch (action->getStatus())
-                {
-                case ActionStatus::COMPLETED:
-                    std::cout << "COMPLETED";
-                    break;
-                case ActionStatus::ERROR:
-                    std::cout << "ERROR";
-                    break;
-                }
-                std::cout << std::endl; // Move to the next line
+            case ActionStatus::COMPLETED:
+                std::cout << "COMPLETED";
+                break;
+            case ActionStatus::ERROR:
+                std::cout << "ERROR";
+                break;
             }
+            std::cout << '\n'; // Move to the next line
         }
         complete();
     }
@@ -325,6 +448,11 @@ const string &BaseAction::getErrorMsg() const
         return "Log";
     }
 
+    void PrintActionsLog::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::PRINT_LOG);
+    }
+
     PrintActionsLog *PrintActionsLog::clone() const
     {
         return new PrintActionsLog(*this);
@@ -345,6 +473,11 @@ const string &BaseAction::getErrorMsg() const
         return "Close";
     }
 
+    void Close::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::CLOSE);
+    }
+
     Close *Close::clone() const
     {
         return new Close(*this);
@@ -353,10 +486,19 @@ const string &BaseAction::getErrorMsg() const
 
 
 // BackupSimulation Implementation
-    BackupSimulation::BackupSimulation() : BaseAction() {}
+    BackupSimulation::BackupSimulation(const string &snapshotName) : BaseAction(), snapshotName(snapshotName) {}
 
+    // Snapshots share all unchanged state with the simulation and with each other,
+    // so each one costs about as much memory as changed since it was taken
     void BackupSimulation::act(Simulation &simulation)
     {
+        if (!snapshotName.empty())
+        {
+            snapshots.erase(snapshotName);
+            snapshots.emplace(snapshotName, simulation);
+            complete();
+            return;
+        }
         if (backup)
         {
             delete backup;
@@ -367,9 +509,19 @@ const string &BaseAction::getErrorMsg() const
 
     const string BackupSimulation::toString() const
     {
+        if (!snapshotName.empty())
+        {
+            return "BackupSimulation " + snapshotName;
+        }
         return "BackupSimulation";
     }
 
+    void BackupSimulation::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::BACKUP);
+        log.writeString(snapshotName);
+    }
+
     BackupSimulation *BackupSimulation::clone() const
     {
         return new BackupSimulation(*this);
@@ -377,25 +529,252 @@ const string &BaseAction::getErrorMsg() const
 
 
 // RestoreSimulation Implementation
-    RestoreSimulation::RestoreSimulation() : BaseAction() {}
+    // Taking a copy of the saved state is O(1) (see Simulation); what restore would spend
+    // its time on is freeing whatever the current state changed since, so that is done
+    // in the background.
+    static void replaceState(Simulation &simulation, const Simulation &state)
+    {
+        std::shared_ptr<Simulation> replaced = std::make_shared<Simulation>(std::move(simulation));
+        simulation = state;
+        Reclaimer::shared().release(std::move(replaced));
+    }
+
+    RestoreSimulation::RestoreSimulation(const string &snapshotName) : BaseAction(), snapshotName(snapshotName) {}
 
     void RestoreSimulation::act(Simulation &simulation)
     {
+        if (!snapshotName.empty())
+        {
+            std::map<string, Simulation>::const_iterator found = snapshots.find(snapshotName);
+            if (found == snapshots.end())
+            {
+                error("Snapshot does not exist");
+                return;
+            }
+            replaceState(simulation, found->second);
+            complete();
+            return;
+        }
         if (backup == nullptr)
         {
             error("No backup available");
             return;
         }
-        simulation = *backup;
+        replaceState(simulation, *backup);
         complete();
 
     }
     const string RestoreSimulation::toString() const
     {
+        if (!snapshotName.empty())
+        {
+            return "RestoreSimulation " + snapshotName;
+        }
         return "RestoreSimulation";
     }
 
+    void RestoreSimulation::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::RESTORE);
+        log.writeString(snapshotName);
+    }
+
+    bool RestoreSimulation::changesState() const
+    {
+        return true;
+    }
+
     RestoreSimulation *RestoreSimulation::clone() const
     {
         return new RestoreSimulation(*this);
     }
+
+// PrintSnapshots Implementation
+    PrintSnapshots::PrintSnapshots() : BaseAction() {}
+
+    void PrintSnapshots::act(Simulation &simulation)
+    {
+        for (const std::pair<const string, Simulation> &snapshot : snapshots)
+        {
+            std::cout << snapshot.first << " step " << snapshot.second.getCurrentStep() << std::endl;
+        }
+        complete();
+    }
+
+    PrintSnapshots *PrintSnapshots::clone() const
+    {
+        return new PrintSnapshots(*this);
+    }
+
+    const string PrintSnapshots::toString() const
+    {
+        return "Snapshots";
+    }
+
+    void PrintSnapshots::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::SNAPSHOTS);
+    }
+
+// DropSnapshot Implementation
+    DropSnapshot::DropSnapshot(const string &snapshotName) : BaseAction(), snapshotName(snapshotName) {}
+
+    void DropSnapshot::act(Simulation &simulation)
+    {
+        if (snapshots.erase(snapshotName) == 0)
+        {
+            error("Snapshot does not exist");
+            return;
+        }
+        complete();
+    }
+
+    DropSnapshot *DropSnapshot::clone() const
+    {
+        return new DropSnapshot(*this);
+    }
+
+    const string DropSnapshot::toString() const
+    {
+        return "DropSnapshot " + snapshotName;
+    }
+
+    void DropSnapshot::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::DROP_SNAPSHOT);
+        log.writeString(snapshotName);
+    }
+
+// Undo Implementation
+    Undo::Undo(int count) : BaseAction(), count(count) {}
+
+    void Undo::act(Simulation &simulation)
+    {
+        if (count < 1 || static_cast<size_t>(count) > undoJournal.size())
+        {
+            error("Not enough actions to undo");
+            return;
+        }
+        Simulation state(undoJournal[undoJournal.size() - count]);
+        undoJournal.erase(undoJournal.end() - count, undoJournal.end());
+        replaceState(simulation, state);
+        complete();
+    }
+
+    int Undo::getCount() const
+    {
+        return count;
+    }
+
+    Undo *Undo::clone() const
+    {
+        return new Undo(*this);
+    }
+
+    const string Undo::toString() const
+    {
+        return "Undo " + std::to_string(count);
+    }
+
+    void Undo::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::UNDO);
+        log.writeInt(count);
+    }
+
+// SaveSimulation Implementation
+    SaveSimulation::SaveSimulation(const string &filePath) : BaseAction(), filePath(filePath) {}
+
+    void SaveSimulation::act(Simulation &simulation)
+    {
+        try
+        {
+            SimulationImage::save(simulation, filePath);
+        }
+        catch (const std::runtime_error &e)
+        {
+            error(e.what());
+            return;
+        }
+        complete();
+    }
+
+    SaveSimulation *SaveSimulation::clone() const
+    {
+        return new SaveSimulation(*this);
+    }
+
+    const string SaveSimulation::toString() const
+    {
+        return "Save " + filePath;
+    }
+
+    void SaveSimulation::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::SAVE);
+        log.writeString(filePath);
+    }
+
+// LoadSimulation Implementation
+    LoadSimulation::LoadSimulation(const string &filePath) : BaseAction(), filePath(filePath) {}
+
+    void LoadSimulation::act(Simulation &simulation)
+    {
+        try
+        {
+            SimulationImage::load(simulation, filePath);
+        }
+        catch (const std::runtime_error &e)
+        {
+            error(e.what());
+            return;
+        }
+        complete();
+    }
+
+    LoadSimulation *LoadSimulation::clone() const
+    {
+        return new LoadSimulation(*this);
+    }
+
+    const string LoadSimulation::toString() const
+    {
+        return "Load " + filePath;
+    }
+
+    void LoadSimulation::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::LOAD);
+        log.writeString(filePath);
+    }
+
+    bool LoadSimulation::changesState() const
+    {
+        return true;
+    }
+
+// RecordedAction Implementation
+    RecordedAction::RecordedAction(const string &description, ActionStatus status) : BaseAction(), description(description)
+    {
+        setStatus(status);
+    }
+
+    void RecordedAction::act(Simulation &simulation)
+    {
+    }
+
+    RecordedAction *RecordedAction::clone() const
+    {
+        return new RecordedAction(*this);
+    }
+
+    const string RecordedAction::toString() const
+    {
+        return description;
+    }
+
+    void RecordedAction::encode(ActionLog &log) const
+    {
+        log.writeCode(ActionCode::RECORDED);
+        log.writeString(description);
+    }
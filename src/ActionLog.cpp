@@ -0,0 +1,121 @@
+#include "ActionLog.h"
+#include <stdexcept>
+#include "Simulation.h"
+#include "Action.h"
+
+ActionLog::StringTable::StringTable() : values(), ids() {}
+
+ActionLog::ActionLog() : bytes(), count(0), strings(std::make_shared<StringTable>()) {}
+
+size_t ActionLog::size() const
+{
+    return count;
+}
+
+bool ActionLog::empty() const
+{
+    return count == 0;
+}
+
+void ActionLog::append(const BaseAction &action)
+{
+    writeByte(static_cast<unsigned char>(action.getStatus()));
+    action.encode(*this);
+    count++;
+}
+
+// The string table is kept: other copies of the log may still refer to it
+void ActionLog::clear()
+{
+    bytes.clear();
+    count = 0;
+}
+
+void ActionLog::writeCode(ActionCode code)
+{
+    writeByte(static_cast<unsigned char>(code));
+}
+
+// Zigzag, so small negative numbers stay short
+void ActionLog::writeInt(int value)
+{
+    unsigned int bits = static_cast<unsigned int>(value);
+    writeUnsigned((bits << 1) ^ (value < 0 ? ~0u : 0u));
+}
+
+void ActionLog::writeString(const string &value)
+{
+    std::unordered_map<string, unsigned int>::const_iterator found = strings->ids.find(value);
+    if (found != strings->ids.end())
+    {
+        writeUnsigned(found->second);
+        return;
+    }
+    unsigned int id = strings->values.size();
+    strings->values.push_back(value);
+    strings->ids.emplace(value, id);
+    writeUnsigned(id);
+}
+
+void ActionLog::writeByte(unsigned char value)
+{
+    bytes.push_back(value);
+}
+
+// Seven bits per byte, low bits first; the high bit marks that more bytes follow
+void ActionLog::writeUnsigned(unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<unsigned char>(value));
+}
+
+ActionLog::Reader::Reader(const ActionLog &log) : log(log), position(0) {}
+
+bool ActionLog::Reader::atEnd() const
+{
+    return position == log.bytes.size();
+}
+
+std::unique_ptr<BaseAction> ActionLog::Reader::next()
+{
+    ActionStatus status = static_cast<ActionStatus>(readByte());
+    return std::unique_ptr<BaseAction>(BaseAction::decode(*this, status));
+}
+
+int ActionLog::Reader::readInt()
+{
+    unsigned int bits = static_cast<unsigned int>(readUnsigned());
+    return static_cast<int>((bits >> 1) ^ (bits & 1 ? ~0u : 0u));
+}
+
+const string &ActionLog::Reader::readString()
+{
+    unsigned long long id = readUnsigned();
+    if (id >= log.strings->values.size())
+        throw std::runtime_error("Action log is corrupt");
+    return log.strings->values[id];
+}
+
+unsigned char ActionLog::Reader::readByte()
+{
+    if (position >= log.bytes.size())
+        throw std::runtime_error("Action log is corrupt");
+    return log.bytes[position++];
+}
+
+unsigned long long ActionLog::Reader::readUnsigned()
+{
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        unsigned char byte = readByte();
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+    throw std::runtime_error("Action log is corrupt");
+}
@@ -1,4 +1,5 @@
 #include "Auxiliary.h"
+#include <climits>
 /*
 This is a 'static' method that receives a string(line) and returns a vector of the string's arguments.
 
@@ -18,3 +19,33 @@ std::vector<std::string> Auxiliary::parseArguments(const std::string& line) {
 
     return arguments;
 }
+
+bool Auxiliary::parseInt(const char *text, size_t length, int &value) {
+    size_t i = 0;
+    bool negative = false;
+    if (length > 0 && (text[0] == '-' || text[0] == '+')) {
+        negative = text[0] == '-';
+        i = 1;
+    }
+    if (i == length) {
+        return false;
+    }
+    long long parsed = 0;
+    for (; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        parsed = parsed * 10 + (text[i] - '0');
+        if (parsed > static_cast<long long>(INT_MAX) + 1) {
+            return false;
+        }
+    }
+    if (negative) {
+        parsed = -parsed;
+    }
+    if (parsed > INT_MAX) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
@@ -0,0 +1,144 @@
+#include "BalanceIndex.h"
+#include <algorithm>
+#include <cstdlib>
+
+static long long closestToZero(long long lo, long long hi)
+{
+    if (lo > 0)
+        return lo;
+    if (hi < 0)
+        return -hi;
+    return 0;
+}
+
+static long long norm(long long x, long long y)
+{
+    return std::max(std::max(std::llabs(x), std::llabs(y)), std::llabs(x + y));
+}
+
+BalanceIndex::BalanceIndex() : levels(), seen() {}
+BalanceIndex::Tree::Tree() : points(), nodes() {}
+
+void BalanceIndex::add(int index, int lifeQualityScore, int economyScore, int environmentScore)
+{
+    Point point = {lifeQualityScore - economyScore, economyScore - environmentScore, index};
+    long long key = static_cast<long long>((static_cast<unsigned long long>(static_cast<unsigned int>(point.x)) << 32) | static_cast<unsigned int>(point.y));
+    // Indices arrive in increasing order, so the first facility with a point keeps it
+    if (!seen.insert(key, index))
+        return;
+
+    // Carry the new point up through the full levels, like incrementing a binary counter.
+    // The merged trees are dropped, not emptied, since copies may still use them.
+    std::shared_ptr<Tree> carry = std::make_shared<Tree>();
+    carry->points.push_back(point);
+    size_t level = 0;
+    while (level < levels.size() && levels[level])
+    {
+        carry->points.insert(carry->points.end(), levels[level]->points.begin(), levels[level]->points.end());
+        levels[level].reset();
+        level++;
+    }
+    if (level == levels.size())
+        levels.emplace_back();
+    build(*carry);
+    levels[level] = carry;
+}
+
+int BalanceIndex::findMostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const
+{
+    long long offsetX = static_cast<long long>(lifeQualityScore) - economyScore;
+    long long offsetY = static_cast<long long>(economyScore) - environmentScore;
+    long long bestBalance = -1;
+    int bestIndex = -1;
+    for (const std::shared_ptr<const Tree> &tree : levels)
+    {
+        if (tree)
+            search(*tree, 0, tree->points.size(), 0, offsetX, offsetY, bestBalance, bestIndex);
+    }
+    return bestIndex;
+}
+
+void BalanceIndex::clear()
+{
+    levels.clear();
+    seen.clear();
+}
+
+void BalanceIndex::build(Tree &tree)
+{
+    tree.nodes.assign(tree.points.size(), Node());
+    build(tree, 0, tree.points.size(), 0);
+}
+
+void BalanceIndex::build(Tree &tree, size_t lo, size_t hi, int depth)
+{
+    size_t mid = (lo + hi) / 2;
+    vector<Point>::iterator first = tree.points.begin();
+    if (depth % 2 == 0)
+        std::nth_element(first + lo, first + mid, first + hi, [](const Point &a, const Point &b) { return a.x < b.x; });
+    else
+        std::nth_element(first + lo, first + mid, first + hi, [](const Point &a, const Point &b) { return a.y < b.y; });
+
+    const Point &point = tree.points[mid];
+    Node node = {point.x, point.x, point.y, point.y, point.index};
+    if (lo < mid)
+    {
+        build(tree, lo, mid, depth + 1);
+        const Node &left = tree.nodes[(lo + mid) / 2];
+        node.minX = std::min(node.minX, left.minX);
+        node.maxX = std::max(node.maxX, left.maxX);
+        node.minY = std::min(node.minY, left.minY);
+        node.maxY = std::max(node.maxY, left.maxY);
+        node.minIndex = std::min(node.minIndex, left.minIndex);
+    }
+    if (mid + 1 < hi)
+    {
+        build(tree, mid + 1, hi, depth + 1);
+        const Node &right = tree.nodes[(mid + 1 + hi) / 2];
+        node.minX = std::min(node.minX, right.minX);
+        node.maxX = std::max(node.maxX, right.maxX);
+        node.minY = std::min(node.minY, right.minY);
+        node.maxY = std::max(node.maxY, right.maxY);
+        node.minIndex = std::min(node.minIndex, right.minIndex);
+    }
+    tree.nodes[mid] = node;
+}
+
+// Branch and bound: a subtree is skipped when even the closest corner of its bounding
+// box cannot beat the best pick so far
+void BalanceIndex::search(const Tree &tree, size_t lo, size_t hi, int depth, long long offsetX, long long offsetY,
+                          long long &bestBalance, int &bestIndex)
+{
+    size_t mid = (lo + hi) / 2;
+    const Node &node = tree.nodes[mid];
+
+    long long lowerBound = std::max(std::max(
+        closestToZero(node.minX + offsetX, node.maxX + offsetX),
+        closestToZero(node.minY + offsetY, node.maxY + offsetY)),
+        closestToZero(node.minX + node.minY + offsetX + offsetY, node.maxX + node.maxY + offsetX + offsetY));
+    if (bestIndex >= 0 && (lowerBound > bestBalance || (lowerBound == bestBalance && node.minIndex > bestIndex)))
+        return;
+
+    const Point &point = tree.points[mid];
+    long long balance = norm(point.x + offsetX, point.y + offsetY);
+    if (bestIndex < 0 || balance < bestBalance || (balance == bestBalance && point.index < bestIndex))
+    {
+        bestBalance = balance;
+        bestIndex = point.index;
+    }
+
+    // The side holding the query point first, so the other side is more likely pruned
+    bool queryLeft = (depth % 2 == 0) ? -offsetX < point.x : -offsetY < point.y;
+    for (int side = 0; side < 2; side++)
+    {
+        if ((side == 0) == queryLeft)
+        {
+            if (lo < mid)
+                search(tree, lo, mid, depth + 1, offsetX, offsetY, bestBalance, bestIndex);
+        }
+        else if (mid + 1 < hi)
+        {
+            search(tree, mid + 1, hi, depth + 1, offsetX, offsetY, bestBalance, bestIndex);
+        }
+    }
+}
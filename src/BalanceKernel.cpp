@@ -0,0 +1,163 @@
+#include "BalanceKernel.h"
+#include <climits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BALANCE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+typedef int (*BalanceFunction)(const int *, const int *, const int *, size_t, int, int, int);
+
+// Scans from index begin, keeping the first of equally balanced entries
+static int scalarScan(const int *life, const int *economy, const int *environment, size_t begin, size_t count,
+                      int lifeQualityScore, int economyScore, int environmentScore, int &bestBalance, int bestIndex)
+{
+    for (size_t i = begin; i < count; i++)
+    {
+        int a = life[i] + lifeQualityScore;
+        int b = economy[i] + economyScore;
+        int c = environment[i] + environmentScore;
+        int high = a > b ? a : b;
+        high = high > c ? high : c;
+        int low = a < b ? a : b;
+        low = low < c ? low : c;
+        if (high - low < bestBalance)
+        {
+            bestBalance = high - low;
+            bestIndex = static_cast<int>(i);
+        }
+    }
+    return bestIndex;
+}
+
+static int findScalar(const int *life, const int *economy, const int *environment, size_t count,
+                      int lifeQualityScore, int economyScore, int environmentScore)
+{
+    int bestBalance = INT_MAX;
+    return scalarScan(life, economy, environment, 0, count, lifeQualityScore, economyScore, environmentScore, bestBalance, 0);
+}
+
+#ifdef BALANCE_KERNEL_X86
+
+// Each lane keeps its own first best; the lanes are then merged by balance, then index
+static int mergeLanes(const int *balances, const int *indices, int lanes, int &bestBalance)
+{
+    int bestIndex = 0;
+    bestBalance = INT_MAX;
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        if (balances[lane] < bestBalance || (balances[lane] == bestBalance && indices[lane] < bestIndex))
+        {
+            bestBalance = balances[lane];
+            bestIndex = indices[lane];
+        }
+    }
+    return bestIndex;
+}
+
+__attribute__((target("avx2")))
+static int findAvx2(const int *life, const int *economy, const int *environment, size_t count,
+                    int lifeQualityScore, int economyScore, int environmentScore)
+{
+    const __m256i lifeOffset = _mm256_set1_epi32(lifeQualityScore);
+    const __m256i economyOffset = _mm256_set1_epi32(economyScore);
+    const __m256i environmentOffset = _mm256_set1_epi32(environmentScore);
+    __m256i bestBalances = _mm256_set1_epi32(INT_MAX);
+    __m256i bestIndices = _mm256_setzero_si256();
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i stride = _mm256_set1_epi32(8);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i a = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(life + i)), lifeOffset);
+        __m256i b = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(economy + i)), economyOffset);
+        __m256i c = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(environment + i)), environmentOffset);
+        __m256i high = _mm256_max_epi32(_mm256_max_epi32(a, b), c);
+        __m256i low = _mm256_min_epi32(_mm256_min_epi32(a, b), c);
+        __m256i balances = _mm256_sub_epi32(high, low);
+        __m256i better = _mm256_cmpgt_epi32(bestBalances, balances);
+        bestBalances = _mm256_blendv_epi8(bestBalances, balances, better);
+        bestIndices = _mm256_blendv_epi8(bestIndices, indices, better);
+        indices = _mm256_add_epi32(indices, stride);
+    }
+
+    alignas(32) int laneBalances[8];
+    alignas(32) int laneIndices[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(laneBalances), bestBalances);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(laneIndices), bestIndices);
+    int bestBalance;
+    int bestIndex = mergeLanes(laneBalances, laneIndices, i == 0 ? 0 : 8, bestBalance);
+    return scalarScan(life, economy, environment, i, count, lifeQualityScore, economyScore, environmentScore, bestBalance, bestIndex);
+}
+
+__attribute__((target("sse4.1")))
+static int findSse41(const int *life, const int *economy, const int *environment, size_t count,
+                     int lifeQualityScore, int economyScore, int environmentScore)
+{
+    const __m128i lifeOffset = _mm_set1_epi32(lifeQualityScore);
+    const __m128i economyOffset = _mm_set1_epi32(economyScore);
+    const __m128i environmentOffset = _mm_set1_epi32(environmentScore);
+    __m128i bestBalances = _mm_set1_epi32(INT_MAX);
+    __m128i bestIndices = _mm_setzero_si128();
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i stride = _mm_set1_epi32(4);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i a = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(life + i)), lifeOffset);
+        __m128i b = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(economy + i)), economyOffset);
+        __m128i c = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(environment + i)), environmentOffset);
+        __m128i high = _mm_max_epi32(_mm_max_epi32(a, b), c);
+        __m128i low = _mm_min_epi32(_mm_min_epi32(a, b), c);
+        __m128i balances = _mm_sub_epi32(high, low);
+        __m128i better = _mm_cmpgt_epi32(bestBalances, balances);
+        bestBalances = _mm_blendv_epi8(bestBalances, balances, better);
+        bestIndices = _mm_blendv_epi8(bestIndices, indices, better);
+        indices = _mm_add_epi32(indices, stride);
+    }
+
+    alignas(16) int laneBalances[4];
+    alignas(16) int laneIndices[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(laneBalances), bestBalances);
+    _mm_store_si128(reinterpret_cast<__m128i *>(laneIndices), bestIndices);
+    int bestBalance;
+    int bestIndex = mergeLanes(laneBalances, laneIndices, i == 0 ? 0 : 4, bestBalance);
+    return scalarScan(life, economy, environment, i, count, lifeQualityScore, economyScore, environmentScore, bestBalance, bestIndex);
+}
+
+#endif
+
+static BalanceFunction chooseImplementation(const char *&name)
+{
+#ifdef BALANCE_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        name = "avx2";
+        return findAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        name = "sse4.1";
+        return findSse41;
+    }
+#endif
+    name = "scalar";
+    return findScalar;
+}
+
+static const char *implementationName = "scalar";
+static const BalanceFunction implementation = chooseImplementation(implementationName);
+
+int BalanceKernel::findMostBalanced(const int *lifeQualityScores, const int *economyScores, const int *environmentScores,
+                                    size_t count, int lifeQualityScore, int economyScore, int environmentScore)
+{
+    return implementation(lifeQualityScores, economyScores, environmentScores, count, lifeQualityScore, economyScore, environmentScore);
+}
+
+const char *BalanceKernel::getImplementationName()
+{
+    return implementationName;
+}
@@ -0,0 +1,75 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BalanceKernel.h"
+#include "OutputRedirect.h"
+#include "Simulation.h"
+#include "PolicyRegistry.h"
+
+void Benchmark::planning(const Simulation &simulation, int plans, int steps, std::ostream &out)
+{
+    if (simulation.settlements.empty() || simulation.getFacilitiesOptions().empty())
+        throw std::runtime_error("The planning benchmark needs settlements and facilities");
+    if (plans <= 0 || steps <= 0)
+        throw std::runtime_error("The planning benchmark needs at least one plan and one step");
+
+    out << "Planning " << plans << " plans for " << steps << " steps" << std::endl;
+    // bal scans small catalogs with the balance kernel, whose speed depends on the path taken
+    out << "Balance kernel: " << BalanceKernel::getImplementationName() << std::endl;
+    const int policies[] = {PolicyRegistry::BALANCED, PolicyRegistry::HORIZON};
+    for (int policyId : policies)
+    {
+        Simulation run(simulation);
+        for (int i = 0; i < plans; i++)
+        {
+            run.addPlan(*run.settlements[i % run.settlements.size()], policyId);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++)
+        {
+            run.step();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        out << PolicyRegistry::getShortName(policyId) << ": " << seconds * 1e3 / steps << " ms per step, "
+            << seconds * 1e9 / (static_cast<double>(steps) * plans) << " ns per plan and step" << std::endl;
+    }
+}
+
+void Benchmark::commands(const Simulation &simulation, int count, std::ostream &out)
+{
+    if (count <= 0)
+        throw std::runtime_error("The command benchmark needs at least one command");
+
+    // Built before timing, so only actionHandler is measured
+    const char *const unknown[] = {"planStatuz 0", "snapshot", "drop x", "Step 1"};
+    const char *const known[] = {"planStatus 0", "snapshots", "dropSnapshot x", "step 0"};
+    const char *const *streams[] = {unknown, known};
+    const char *const names[] = {"unknown commands", "commands"};
+
+    out << "Running " << count << " command lines" << std::endl;
+    for (int s = 0; s < 2; s++)
+    {
+        std::vector<std::string> lines;
+        lines.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            lines.push_back(streams[s][i % 4]);
+        }
+
+        Simulation run(simulation);
+        double seconds;
+        {
+            OutputRedirect redirect(nullptr);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (const std::string &line : lines)
+            {
+                run.actionHandler(line);
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        out << names[s] << ": " << seconds * 1e9 / count << " ns per line" << std::endl;
+    }
+}
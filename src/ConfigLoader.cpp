@@ -0,0 +1,256 @@
+#include "ConfigLoader.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "Auxiliary.h"
+#include "MappedFile.h"
+#include "PolicyRegistry.h"
+#include "Simulation.h"
+#include "SimulationImage.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// A word of the mapped file
+struct Token {
+    const char *data;
+    size_t size;
+
+    bool operator==(const char *word) const
+    {
+        return std::strlen(word) == size && std::memcmp(data, word, size) == 0;
+    }
+    string str() const { return string(data, size); }
+};
+
+// More than any known line needs, so longer lines are still caught as malformed
+const size_t MAX_TOKENS = 8;
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+class LineError : public std::runtime_error {
+    public:
+        explicit LineError(const string &message) : std::runtime_error(message) {}
+};
+
+// Splits [begin, end) into tokens; returns how many there are, which may exceed MAX_TOKENS
+size_t tokenize(const char *begin, const char *end, Token *tokens)
+{
+    size_t count = 0;
+    const char *p = begin;
+    while (true)
+    {
+        while (p < end && isBlank(*p))
+            p++;
+        if (p == end)
+            return count;
+        const char *start = p;
+        while (p < end && !isBlank(*p))
+            p++;
+        if (count < MAX_TOKENS)
+            tokens[count] = Token{start, static_cast<size_t>(p - start)};
+        count++;
+    }
+}
+
+int toInt(const Token &token)
+{
+    int value = 0;
+    if (!Auxiliary::parseInt(token.data, token.size, value))
+        throw LineError("'" + token.str() + "' is not a number in int range");
+    return value;
+}
+
+// One of the digits 0 to last, as settlement types and facility categories are given
+int toChoice(const Token &token, int last, const char *what)
+{
+    if (token.size != 1 || token.data[0] < '0' || token.data[0] > '0' + last)
+        throw LineError("'" + token.str() + "' is not a " + what);
+    return token.data[0] - '0';
+}
+
+void expectArguments(size_t count, size_t expected)
+{
+    if (count != expected)
+        throw LineError("expected " + std::to_string(expected - 1) + " arguments, found " + std::to_string(count - 1));
+}
+
+// Settlement, facility and plan lines, parsed but not yet applied
+enum class EntryKind {SETTLEMENT, FACILITY, PLAN, COMMAND, MALFORMED};
+
+struct Entry {
+    EntryKind kind;
+    size_t line;      // Within its chunk, from 0
+    size_t index;     // Into the chunk's settlements, facilities, plans or errors
+    const char *text; // The line without surrounding blanks, to run as a command
+    size_t textSize;
+};
+
+struct PlanLine {
+    string settlement;
+    int policyId; // -1 if unknown
+};
+
+// A run of whole lines, parsed on its own thread
+struct Chunk {
+    Chunk() : begin(nullptr), end(nullptr), lines(0), entries(), settlements(), facilities(), plans(), errors() {}
+    Chunk(const Chunk &other) = delete;
+    Chunk &operator=(const Chunk &other) = delete;
+    const char *begin;
+    const char *end;
+    size_t lines;
+    vector<Entry> entries;
+    vector<std::unique_ptr<Settlement>> settlements;
+    vector<FacilityType> facilities;
+    vector<PlanLine> plans;
+    vector<string> errors;
+};
+
+// Below this, a chunk is not worth a thread
+const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+// Parses the lines of a chunk. Stops at the first malformed one: loading ends there.
+void parseChunk(Chunk &chunk)
+{
+    Token tokens[MAX_TOKENS];
+    const char *p = chunk.begin;
+    while (p < chunk.end)
+    {
+        // memchr is vectorized by the C library, and most of a config line is its words
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', chunk.end - p));
+        const char *lineEnd = newline != nullptr ? newline : chunk.end;
+        const char *lineStart = p;
+        p = lineEnd + 1;
+        size_t line = chunk.lines++;
+
+        size_t count = tokenize(lineStart, lineEnd, tokens);
+        if (count == 0 || tokens[0].data[0] == '#')
+            continue;
+        const char *textEnd = count <= MAX_TOKENS ? tokens[count - 1].data + tokens[count - 1].size : lineEnd;
+        Entry entry = {EntryKind::COMMAND, line, 0, tokens[0].data, static_cast<size_t>(textEnd - tokens[0].data)};
+        try
+        {
+            if (tokens[0] == "settlement")
+            {
+                expectArguments(count, 3);
+                SettlementType type = static_cast<SettlementType>(toChoice(tokens[2], 2, "settlement type"));
+                entry.kind = EntryKind::SETTLEMENT;
+                entry.index = chunk.settlements.size();
+                chunk.settlements.emplace_back(new Settlement(tokens[1].str(), type));
+            }
+            else if (tokens[0] == "facility")
+            {
+                expectArguments(count, 7);
+                FacilityCategory category = static_cast<FacilityCategory>(toChoice(tokens[2], 2, "facility category"));
+                entry.kind = EntryKind::FACILITY;
+                entry.index = chunk.facilities.size();
+                chunk.facilities.push_back(FacilityType(tokens[1].str(), category, toInt(tokens[3]), toInt(tokens[4]), toInt(tokens[5]), toInt(tokens[6])));
+            }
+            else if (tokens[0] == "plan")
+            {
+                expectArguments(count, 3);
+                entry.kind = EntryKind::PLAN;
+                entry.index = chunk.plans.size();
+                chunk.plans.push_back(PlanLine{tokens[1].str(), PolicyRegistry::find(tokens[2].str())});
+            }
+        }
+        catch (const LineError &e)
+        {
+            entry.kind = EntryKind::MALFORMED;
+            entry.index = chunk.errors.size();
+            chunk.errors.push_back(e.what());
+            chunk.entries.push_back(entry);
+            return;
+        }
+        chunk.entries.push_back(entry);
+    }
+}
+
+// Applies a parsed line; false if the simulation turned it down
+bool applyEntry(Simulation &simulation, Chunk &chunk, const Entry &entry)
+{
+    switch (entry.kind)
+    {
+        case EntryKind::SETTLEMENT:
+        {
+            std::unique_ptr<Settlement> &settlement = chunk.settlements[entry.index];
+            if (!simulation.addSettlement(settlement.get()))
+                return false;
+            settlement.release();
+            return true;
+        }
+        case EntryKind::FACILITY:
+            return simulation.addFacility(chunk.facilities[entry.index]);
+        case EntryKind::PLAN:
+        {
+            const PlanLine &plan = chunk.plans[entry.index];
+            if (plan.policyId < 0 || !simulation.isSettlementExists(plan.settlement))
+                return false;
+            simulation.addPlan(simulation.getSettlement(plan.settlement), plan.policyId);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+}
+
+void ConfigLoader::load(Simulation &simulation, const string &path)
+{
+    MappedFile file(path, "config file");
+    const char *data = file.getData();
+    size_t size = file.getSize();
+    if (SimulationImage::isImage(string(data, std::min(size, static_cast<size_t>(16)))))
+    {
+        SimulationImage::load(simulation, path);
+        return;
+    }
+
+    // Cut the file into chunks at line boundaries, a few per thread so that stealing
+    // evens them out
+    ThreadPool &pool = ThreadPool::shared();
+    size_t chunkCount = std::min(static_cast<size_t>(pool.getThreadCount()) * 4, size / MIN_CHUNK_SIZE);
+    chunkCount = std::max(chunkCount, static_cast<size_t>(1));
+    vector<Chunk> chunks(chunkCount);
+    const char *begin = data;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const char *end = data + size;
+        if (i + 1 < chunkCount)
+        {
+            end = std::max(begin, data + size * (i + 1) / chunkCount);
+            const char *newline = static_cast<const char *>(std::memchr(end, '\n', data + size - end));
+            end = newline != nullptr ? newline + 1 : data + size;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+
+    pool.parallelFor(chunkCount, [&chunks](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            parseChunk(chunks[i]);
+    });
+
+    // Apply in file order, so duplicates and plan ids come out as if read line by line
+    size_t firstLine = 1;
+    for (Chunk &chunk : chunks)
+    {
+        for (const Entry &entry : chunk.entries)
+        {
+            if (entry.kind == EntryKind::MALFORMED)
+                throw std::runtime_error(path + ":" + std::to_string(firstLine + entry.line) + ": " + chunk.errors[entry.index]);
+            if (!applyEntry(simulation, chunk, entry))
+            {
+                // Not a config line, or turned down: run it as a command to report it
+                simulation.actionHandler(string(entry.text, entry.textSize));
+            }
+        }
+        firstLine += chunk.lines;
+    }
+}
@@ -72,6 +72,12 @@ Facility::Facility(const FacilityType &type, const string &settlementName)
 {
 }
 
+// Rebuilds a facility from the state a Plan keeps for it
+Facility::Facility(const FacilityType &type, const string &settlementName, FacilityStatus status, int timeLeft)
+    : FacilityType(type), settlementName(settlementName), status(status), timeLeft(timeLeft)
+{
+}
+
 // Getter for settlement name
 const string &Facility::getSettlementName() const
 {
@@ -0,0 +1,107 @@
+#include "FacilityCatalog.h"
+#include <atomic>
+
+// Versions are unique across all catalogs, so a version alone identifies catalog contents
+static std::atomic<unsigned long long> lastVersion(0);
+
+FacilityCatalog::FacilityCatalog()
+    : facilities(), nameIndex(), byCategory(), lifeQualityScores(), economyScores(), environmentScores(), balanceIndex()
+    , version(++lastVersion) {}
+
+// Returns false if a facility with the same name is already listed
+bool FacilityCatalog::add(const FacilityType &facility)
+{
+    if (!nameIndex.insert(facility.getName(), facilities.size()))
+    {
+        return false;
+    }
+    byCategory[static_cast<int>(facility.getCategory())].push_back(facilities.size());
+    lifeQualityScores.push_back(facility.getLifeQualityScore());
+    economyScores.push_back(facility.getEconomyScore());
+    environmentScores.push_back(facility.getEnvironmentScore());
+    balanceIndex.add(facilities.size(), facility.getLifeQualityScore(), facility.getEconomyScore(), facility.getEnvironmentScore());
+    facilities.push_back(facility);
+    version = ++lastVersion;
+    return true;
+}
+
+bool FacilityCatalog::contains(const string &name) const
+{
+    return nameIndex.contains(name);
+}
+
+size_t FacilityCatalog::size() const
+{
+    return facilities.size();
+}
+
+bool FacilityCatalog::empty() const
+{
+    return facilities.empty();
+}
+
+const FacilityType &FacilityCatalog::operator[](size_t index) const
+{
+    return facilities[index];
+}
+
+// Index of an entry of this catalog, from a reference into it
+int FacilityCatalog::indexOf(const FacilityType &facility) const
+{
+    return *nameIndex.find(facility.getName());
+}
+
+const CowVector<int> &FacilityCatalog::getCategory(FacilityCategory category) const
+{
+    return byCategory[static_cast<int>(category)];
+}
+
+const CowVector<int> &FacilityCatalog::getLifeQualityScores() const
+{
+    return lifeQualityScores;
+}
+
+const CowVector<int> &FacilityCatalog::getEconomyScores() const
+{
+    return economyScores;
+}
+
+const CowVector<int> &FacilityCatalog::getEnvironmentScores() const
+{
+    return environmentScores;
+}
+
+const BalanceIndex &FacilityCatalog::getBalanceIndex() const
+{
+    return balanceIndex;
+}
+
+unsigned long long FacilityCatalog::getVersion() const
+{
+    return version;
+}
+
+CowVector<FacilityType>::const_iterator FacilityCatalog::begin() const
+{
+    return facilities.begin();
+}
+
+CowVector<FacilityType>::const_iterator FacilityCatalog::end() const
+{
+    return facilities.end();
+}
+
+void FacilityCatalog::clear()
+{
+    facilities.clear();
+    nameIndex.clear();
+    for (CowVector<int> &category : byCategory)
+    {
+        category.clear();
+    }
+    lifeQualityScores.clear();
+    economyScores.clear();
+    environmentScores.clear();
+    balanceIndex.clear();
+    version = ++lastVersion;
+}
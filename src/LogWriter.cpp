@@ -0,0 +1,155 @@
+#include "LogWriter.h"
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::unique_ptr<LogWriter> sharedWriter;
+
+const size_t LogWriter::CAPACITY;
+
+LogWriter::LogWriter(const string &path, FsyncPolicy fsyncPolicy)
+    : fd(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644))
+    , fsyncPolicy(fsyncPolicy)
+    , slots(new string[CAPACITY])
+    , head(0)
+    , tail(0)
+    , backlog()
+    , sleeping(false)
+    , stopping(false)
+    , mutex()
+    , wakeCv()
+    , writer()
+{
+    if (fd < 0)
+        throw std::runtime_error("Failed to open log file: " + path);
+    writer = std::thread(&LogWriter::writerLoop, this);
+}
+
+LogWriter::~LogWriter()
+{
+    // Move the backlog into the ring as the writer makes room
+    while (!backlog.empty())
+    {
+        if (tryPush(backlog.front()))
+        {
+            backlog.pop_front();
+        }
+        else
+        {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+    stopping.store(true);
+    wake();
+    writer.join();
+    close(fd);
+}
+
+void LogWriter::submit(string line)
+{
+    while (!backlog.empty() && tryPush(backlog.front()))
+    {
+        backlog.pop_front();
+    }
+    if (!backlog.empty() || !tryPush(line))
+    {
+        backlog.push_back(std::move(line));
+    }
+    wake();
+}
+
+bool LogWriter::tryPush(string &line)
+{
+    size_t slot = tail.load(std::memory_order_relaxed);
+    if (slot - head.load(std::memory_order_acquire) == CAPACITY)
+        return false;
+    slots[slot % CAPACITY].swap(line);
+    tail.store(slot + 1, std::memory_order_release);
+    return true;
+}
+
+// Only takes the lock when the writer has gone to sleep
+void LogWriter::wake()
+{
+    if (sleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeCv.notify_one();
+    }
+}
+
+void LogWriter::writerLoop()
+{
+    string batch;
+    while (true)
+    {
+        size_t first = head.load(std::memory_order_relaxed);
+        size_t last = tail.load(std::memory_order_acquire);
+        if (first == last)
+        {
+            if (stopping.load())
+                return;
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping.store(true);
+            // The timeout covers a submit that checked sleeping just before it was set
+            wakeCv.wait_for(lock, std::chrono::milliseconds(100), [this, first] {
+                return tail.load(std::memory_order_acquire) != first || stopping.load();
+            });
+            sleeping.store(false);
+            continue;
+        }
+
+        batch.clear();
+        for (size_t i = first; i != last; i++)
+        {
+            string &line = slots[i % CAPACITY];
+            batch += line;
+            batch += '\n';
+            string().swap(line);
+            if (fsyncPolicy == FsyncPolicy::ALWAYS)
+            {
+                writeAll(batch);
+                fdatasync(fd);
+                batch.clear();
+            }
+        }
+        head.store(last, std::memory_order_release);
+        if (!batch.empty())
+        {
+            writeAll(batch);
+            if (fsyncPolicy == FsyncPolicy::BATCH)
+                fdatasync(fd);
+        }
+    }
+}
+
+void LogWriter::writeAll(const string &data)
+{
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Error: Failed to write log file" << std::endl;
+            return;
+        }
+        written += result;
+    }
+}
+
+void LogWriter::configure(const string &path, FsyncPolicy fsyncPolicy)
+{
+    sharedWriter.reset(new LogWriter(path, fsyncPolicy));
+}
+
+LogWriter *LogWriter::shared()
+{
+    return sharedWriter.get();
+}
@@ -0,0 +1,47 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const string &path, const string &kind) : data(nullptr), size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open " + kind + ": " + path);
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Failed to read " + kind + ": " + path);
+    }
+    size = info.st_size;
+    if (size > 0)
+    {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Failed to map " + kind + ": " + path);
+        }
+        data = static_cast<const char *>(mapped);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+        munmap(const_cast<char *>(data), size);
+}
+
+const char *MappedFile::getData() const
+{
+    return data;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size;
+}
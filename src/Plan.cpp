@@ -1,45 +1,31 @@
 #include "Plan.h"
 #include <iostream>
-#include "SelectionPolicy.h"
+#include "PolicyRegistry.h"
 #include <sstream>
+#include <exception>
+#include <stdexcept>
 
 // Constructor
-Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions)
+Plan::Plan(const int planId, std::shared_ptr<const Settlement> settlement, int policyId, long long clock)
     : plan_id(planId)
     , settlement(settlement)
-    , selectionPolicy(selectionPolicy)
+    , policyId(policyId)
+    , selectionPolicy(PolicyRegistry::create(policyId, 0, 0, 0))
     , status(PlanStatus::AVALIABLE)
-    , facilities()
-    , underConstruction()
-    , facilityOptions(facilityOptions)
+    , operationalCounts()
+    , completionOrder()
+    , constructionTypes()
+    , constructionTimeLeft()
     , life_quality_score(0)
     , economy_score(0)
     , environment_score(0) 
+    , clock(clock)
+    , recordCompletions(false)
+    , recentCompletions()
 {
 }
 
 
-//DEEP COPY CONSTRUCTOR
-
-Plan::Plan(const int planId,
-           const Settlement &settlement,
-           SelectionPolicy *selectionPolicy,
-           const std::vector<FacilityType> &facilityOptions,
-           int life_quality_score,
-           int economy_score,
-           int environment_score,
-           std::vector<Facility *> facilities,
-           std::vector<Facility *> underConstruction)
-    : Plan(planId, settlement, selectionPolicy, facilityOptions) // Delegate to first constructor
-{
-    // Additional initialization
-    this->life_quality_score = life_quality_score;
-    this->economy_score = economy_score;
-    this->environment_score = environment_score;
-    this->facilities = std::move(facilities);
-    this->underConstruction = std::move(underConstruction);
-}
-
 const int Plan::getlifeQualityScore() const {
     return life_quality_score;
 }
@@ -52,90 +38,325 @@ const int Plan::getEnvironmentScore() const {
     return environment_score;
 }
 
-void Plan::setSelectionPolicy(SelectionPolicy *newSelectionPolicy) {
-    if (selectionPolicy != nullptr) {
-        delete selectionPolicy;
+void Plan::setSelectionPolicy(int newPolicyId, const FacilityCatalog &facilityOptions) {
+    int lifeQualityScore = life_quality_score;
+    int economyScore = economy_score;
+    int environmentScore = environment_score;
+    for (int type : constructionTypes) {
+        lifeQualityScore += facilityOptions[type].getLifeQualityScore();
+        economyScore += facilityOptions[type].getEconomyScore();
+        environmentScore += facilityOptions[type].getEnvironmentScore();
     }
 
-    selectionPolicy = newSelectionPolicy;
+    selectionPolicy = PolicyRegistry::create(newPolicyId, lifeQualityScore, economyScore, environmentScore);
+    policyId = newPolicyId;
 }
 
-void Plan::step() {
+void Plan::step(const FacilityCatalog &facilityOptions) {
+    switch (selectionPolicy.getKind()) {
+        case PolicyVariant::Kind::NAIVE:
+            stepWith(selectionPolicy.asNaive(), facilityOptions);
+            break;
+        case PolicyVariant::Kind::BALANCED:
+            stepWith(selectionPolicy.asBalanced(), facilityOptions);
+            break;
+        case PolicyVariant::Kind::ECONOMY:
+            stepWith(selectionPolicy.asEconomy(), facilityOptions);
+            break;
+        case PolicyVariant::Kind::SUSTAINABILITY:
+            stepWith(selectionPolicy.asSustainability(), facilityOptions);
+            break;
+        case PolicyVariant::Kind::HORIZON:
+            stepWith(selectionPolicy.asHorizon(), facilityOptions);
+            break;
+        case PolicyVariant::Kind::CUSTOM:
+            stepWith(selectionPolicy.asCustom(), facilityOptions);
+            break;
+    }
+}
+
+template <typename Policy>
+void Plan::stepWith(Policy &policy, const FacilityCatalog &facilityOptions) {
 
     // Stage 1: Check if plan is BUSY
 
     if (status != PlanStatus::BUSY) {
-        // Stage 2: Select and add new facilities if possible
-    while (underConstruction.size() < static_cast<size_t>(settlement.getConstructionLimit()) && status != PlanStatus::BUSY) {
-            // Select facility based on current policy
-            Facility* newFacility = new Facility(selectionPolicy->selectFacility(facilityOptions), settlement.getName());
-            addFacility(newFacility);
+        // Stage 2: Fill every free slot with the policy's next picks in one call
+        size_t first = constructionTypes.size();
+        int freeSlots = settlement->getConstructionLimit() - static_cast<int>(first);
+        if (freeSlots > 0) {
+            try {
+                policy.selectFacilities(facilityOptions, freeSlots, constructionTypes);
+            }
+            catch (...) {
+                // Picks made before the policy failed stay, as they would one call at a time
+                addConstructionTimes(first, facilityOptions);
+                throw;
+            }
+            addConstructionTimes(first, facilityOptions);
         }
     }
 
-    // Stage 3: Process facilities under construction
-    vector<Facility*> completedFacilities;
-    for (int i = underConstruction.size() - 1; i >= 0; i--)
-    {
-        FacilityStatus facilityStatus = underConstruction[i]->step();
-        if (facilityStatus == FacilityStatus::OPERATIONAL) {
-            // Update scores
-            addFacility(underConstruction[i]);
-            underConstruction.erase(underConstruction.begin() + i);
+    finishStep(facilityOptions);
+}
+
+// Starts the timers of the facilities placed from index first on
+void Plan::addConstructionTimes(size_t first, const FacilityCatalog &facilityOptions) {
+    for (size_t i = first; i < constructionTypes.size(); i++) {
+        constructionTimeLeft.push_back(facilityOptions[constructionTypes[i]].getCost());
     }
+}
 
+// Rest of a step once new facilities have been placed
+void Plan::finishStep(const FacilityCatalog &facilityOptions) {
+    // Stage 3: Process facilities under construction
+    for (int i = constructionTypes.size() - 1; i >= 0; i--)
+    {
+        int &timeLeft = constructionTimeLeft[i];
+        if (timeLeft > 0 && --timeLeft == 0) {
+            completeConstruction(i, facilityOptions);
+        }
     }
 
     // Stage 4: Update plan status
-    status = (underConstruction.size() >= static_cast<size_t>(settlement.getConstructionLimit()))
+    status = (constructionTypes.size() >= static_cast<size_t>(settlement->getConstructionLimit()))
         ? PlanStatus::BUSY 
         : PlanStatus::AVALIABLE;
+    clock++;
 }
 
-void Plan::printStatus(){
+// Moves a finished facility to the operational column and adds its scores
+void Plan::completeConstruction(size_t index, const FacilityCatalog &facilityOptions) {
+    int type = constructionTypes[index];
+    const FacilityType &facility = facilityOptions[type];
+    life_quality_score += facility.getLifeQualityScore();
+    economy_score += facility.getEconomyScore();
+    environment_score += facility.getEnvironmentScore();
+    if (operationalCounts.size() <= static_cast<size_t>(type)) {
+        operationalCounts.resize(type + 1, 0);
+    }
+    operationalCounts[type]++;
+    if (completionOrder.empty() || completionOrder.back().repeats != 1) {
+        completionOrder.emplace_back();
+    }
+    completionOrder.back().types.push_back(type);
+    if (recordCompletions) {
+        recentCompletions.push_back(type);
+    }
 
-    std::cout << toString();
+    constructionTypes.erase(constructionTypes.begin() + index);
+    constructionTimeLeft.erase(constructionTimeLeft.begin() + index);
 }
 
-const vector<Facility*> &Plan::getFacilities() const {
-    return facilities;
+// Counts running timers down; callers never pass enough steps to finish one
+void Plan::countDown(int steps) {
+    for (int &timeLeft : constructionTimeLeft) {
+        if (timeLeft > 0) {
+            timeLeft -= steps;
+        }
+    }
 }
 
-const int Plan::getID() const {
-    return plan_id;
+// Shorter runs are stepped normally; looking for a period would cost more than it saves
+static const long long PERIOD_SEARCH_MIN_STEPS = 1024;
+// Give up looking for a period after this many events
+static const size_t PERIOD_SEARCH_MAX_STATES = 4096;
+
+// Runs the plan up to targetStep. While the plan is BUSY a step only counts timers down,
+// so those stretches are skipped in one go and step() runs only when something happens.
+void Plan::advanceTo(long long targetStep, const FacilityCatalog &facilityOptions) {
+    // Pick the loop for the policy once, rather than on every step
+    switch (selectionPolicy.getKind()) {
+        case PolicyVariant::Kind::NAIVE:
+            advanceWith(selectionPolicy.asNaive(), targetStep, facilityOptions);
+            break;
+        case PolicyVariant::Kind::BALANCED:
+            advanceWith(selectionPolicy.asBalanced(), targetStep, facilityOptions);
+            break;
+        case PolicyVariant::Kind::ECONOMY:
+            advanceWith(selectionPolicy.asEconomy(), targetStep, facilityOptions);
+            break;
+        case PolicyVariant::Kind::SUSTAINABILITY:
+            advanceWith(selectionPolicy.asSustainability(), targetStep, facilityOptions);
+            break;
+        case PolicyVariant::Kind::HORIZON:
+            advanceWith(selectionPolicy.asHorizon(), targetStep, facilityOptions);
+            break;
+        case PolicyVariant::Kind::CUSTOM:
+            advanceWith(selectionPolicy.asCustom(), targetStep, facilityOptions);
+            break;
+    }
 }
 
-void Plan::addFacility(Facility* facility) {
-    // Update scores
+template <typename Policy>
+void Plan::advanceWith(Policy &policy, long long targetStep, const FacilityCatalog &facilityOptions) {
+    int position;
+    bool searchPeriod = targetStep - clock >= PERIOD_SEARCH_MIN_STEPS && policy.cyclePosition(position);
+    std::unordered_map<string, PeriodMark> seen;
+    recordCompletions = searchPeriod;
+    std::exception_ptr failure;
+
+    while (clock < targetStep) {
+        long long next = failure ? nextCompletionStep() : nextEventStep();
+        if (next < 0 || next > targetStep) {
+            next = targetStep + 1;
+        }
 
-    if (facility->getStatus() == FacilityStatus::OPERATIONAL)
-    {
-        life_quality_score += facility->getLifeQualityScore();
-        economy_score += facility->getEconomyScore();
-        environment_score += facility->getEnvironmentScore();
-        facilities.push_back(facility);
+        int idle = static_cast<int>(next - 1 - clock);
+        if (idle > 0) {
+            countDown(idle);
+            clock += idle;
+        }
+        if (clock < targetStep) {
+            if (failure) {
+                finishStep(facilityOptions);
+                continue;
+            }
+            try {
+                stepWith(policy, facilityOptions);
+            }
+            catch (const std::runtime_error &) {
+                // The policy has nothing to pick. Slots stay empty while the facilities
+                // already started keep building, and the error is reported at the end.
+                failure = std::current_exception();
+                searchPeriod = false;
+                finishStep(facilityOptions);
+            }
+            if (searchPeriod) {
+                policy.cyclePosition(position);
+                searchPeriod = skipPeriods(position, seen, targetStep);
+                recordCompletions = searchPeriod;
+            }
+        }
     }
-    else
-    {
-        underConstruction.push_back(facility);
+    recordCompletions = false;
+    recentCompletions.clear();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+// With a cyclic policy and a fixed catalog, the plan's future depends only on its status,
+// the policy's position and the facilities under construction. Once that state repeats,
+// every following period adds the same scores and facilities, so whole periods are applied
+// at once. Returns false when the search should stop.
+bool Plan::skipPeriods(int position, std::unordered_map<string, PeriodMark> &seen, long long targetStep) {
+    string state = std::to_string(static_cast<int>(status)) + ":" + std::to_string(position);
+    for (size_t i = 0; i < constructionTypes.size(); i++) {
+        state += ":" + std::to_string(constructionTypes[i]) + "/" + std::to_string(constructionTimeLeft[i]);
     }
 
+    std::unordered_map<string, PeriodMark>::const_iterator found = seen.find(state);
+    if (found == seen.end()) {
+        PeriodMark mark = {clock, life_quality_score, economy_score, environment_score, recentCompletions.size()};
+        seen.emplace(state, mark);
+        return seen.size() < PERIOD_SEARCH_MAX_STATES;
+    }
+
+    const PeriodMark &start = found->second;
+    long long period = clock - start.clock;
+    long long periods = (targetStep - clock) / period;
+    if (periods > 0) {
+        vector<int> completed(recentCompletions.begin() + start.completed, recentCompletions.end());
+        for (int type : completed) {
+            operationalCounts[type] += periods;
+        }
+        if (!completed.empty()) {
+            completionOrder.emplace_back(completed, static_cast<int>(periods));
+        }
+        life_quality_score += (life_quality_score - start.life_quality_score) * periods;
+        economy_score += (economy_score - start.economy_score) * periods;
+        environment_score += (environment_score - start.environment_score) * periods;
+        clock += period * periods;
+    }
+    return false;
 }
 
+// Brings the timers of a plan that had no event since its clock up to currentStep
+void Plan::catchUp(long long currentStep) {
+    if (clock < currentStep) {
+        countDown(static_cast<int>(currentStep - clock));
+        clock = currentStep;
+    }
+}
+
+// Step in which the plan next selects or completes a facility, or -1 if it never will
+long long Plan::nextEventStep() const {
+    if (status != PlanStatus::BUSY) {
+        return clock + 1;
+    }
+    return nextCompletionStep();
+}
+
+// Step in which the next facility under construction completes, or -1 if none will
+long long Plan::nextCompletionStep() const {
+    int soonest = -1;
+    for (int timeLeft : constructionTimeLeft) {
+        if (timeLeft > 0 && (soonest < 0 || timeLeft < soonest)) {
+            soonest = timeLeft;
+        }
+    }
+    return soonest < 0 ? -1 : clock + soonest;
+}
+
+long long Plan::getClock() const {
+    return clock;
+}
+
+void Plan::printStatus() const {
+
+    std::cout << toString();
+}
+
+// Operational facilities in the order they were completed
+vector<Facility> Plan::getFacilities(const FacilityCatalog &facilityOptions) const {
+    vector<Facility> result;
+    for (const CompletionBlock &block : completionOrder) {
+        for (int i = 0; i < block.repeats; i++) {
+            for (int type : block.types) {
+                result.emplace_back(facilityOptions[type], settlement->getName(), FacilityStatus::OPERATIONAL, 0);
+            }
+        }
+    }
+    return result;
+}
+
+void Plan::addToHash(StateHash &hash) const {
+    hash.add(plan_id);
+    hash.add(settlement->getName());
+    hash.add(policyId);
+    vector<int> policyState;
+    selectionPolicy.get().saveState(policyState);
+    hash.add(static_cast<long long>(policyState.size()));
+    for (int value : policyState) {
+        hash.add(value);
+    }
+    hash.add(static_cast<long long>(status));
+    hash.add(life_quality_score);
+    hash.add(economy_score);
+    hash.add(environment_score);
+    // operationalCounts only grows when needed, so its length is left out
+    for (size_t type = 0; type < operationalCounts.size(); type++) {
+        if (operationalCounts[type] != 0) {
+            hash.add(static_cast<long long>(type));
+            hash.add(operationalCounts[type]);
+        }
+    }
+    hash.add(-1);
+    for (size_t i = 0; i < constructionTypes.size(); i++) {
+        hash.add(constructionTypes[i]);
+        hash.add(constructionTimeLeft[i]);
+    }
+}
+
+const int Plan::getID() const {
+    return plan_id;
+}
 
 const string Plan::toString() const {
-    string result = "planID: " + std::to_string(plan_id) + " settlementName: " + settlement.getName() + "\n";
+    string result = "planID: " + std::to_string(plan_id) + " settlementName: " + settlement->getName() + "\n";
     result += "planStatus: " + string(status == PlanStatus::BUSY ? "BUSY" : "AVALIABLE") + "\n";
-    
-    // Selection policy string representation
-    string policyStr;
-    policyStr = selectionPolicy->toString();
-    if (policyStr == "NaiveSelection") policyStr = "nve";
-    else if (policyStr == "BalancedSelection") policyStr = "bal";
-    else if (policyStr == "EconomySelection") policyStr = "eco";
-    else if (policyStr == "SustainabilitySelection") policyStr = "env";
-    
-    result += "selectionPolicy: " + policyStr + "\n";
+    result += "selectionPolicy: " + PolicyRegistry::getShortName(policyId) + "\n";
     result += "LifeQualityScore: " + std::to_string(life_quality_score) + "\n";
     result += "EconomyScore: " + std::to_string(economy_score) + "\n";
     result += "EnvironmentScore: " + std::to_string(environment_score) + "\n";
@@ -145,95 +366,79 @@ const string Plan::toString() const {
 }
 
 Plan::~Plan() {
-    // Clean up dynamically allocated selection policy
-    if (selectionPolicy) {
-        delete selectionPolicy;
-    }
-
-    // Clean up dynamically allocated facilities
-    for (Facility* facility : underConstruction) {
-        delete facility;
-    }
-    underConstruction.clear();
-
-    for (Facility* facility : facilities) {
-        delete facility;
-    }
-    facilities.clear();
 }
 
 Plan::Plan(const Plan& other) 
     : plan_id(other.plan_id)
-    , settlement(other.settlement) // Settlement assumed to be a raw pointer, copied as-is
-    , selectionPolicy(other.selectionPolicy ? other.selectionPolicy->clone() : nullptr) // Clone policy
+    , settlement(other.settlement) // Settlements never change, so copies share them
+    , policyId(other.policyId)
+    , selectionPolicy(other.selectionPolicy)
     , status(other.status)
-    , facilities()
-    , underConstruction()
-    , facilityOptions(other.facilityOptions)
+    , operationalCounts(other.operationalCounts)
+    , completionOrder(other.completionOrder)
+    , constructionTypes(other.constructionTypes)
+    , constructionTimeLeft(other.constructionTimeLeft)
     , life_quality_score(other.life_quality_score)
     , economy_score(other.economy_score)
     , environment_score(other.environment_score)
+    , clock(other.clock)
+    , recordCompletions(false)
+    , recentCompletions()
      {
-    
-    // Deep copy facilities
-    for (const Facility* facility : other.facilities) {
-        facilities.push_back(facility->clone());
-    }
-
-    for (const Facility* facility : other.underConstruction) {
-        underConstruction.push_back(facility->clone());
-    }
 }
 
-
 Plan::Plan(Plan&& other) noexcept 
     : plan_id(other.plan_id)
-    , settlement(other.settlement)
-    , selectionPolicy(other.selectionPolicy)
+    , settlement(std::move(other.settlement))
+    , policyId(other.policyId)
+    , selectionPolicy(std::move(other.selectionPolicy))
     , status(other.status)
-    , facilities(std::move(other.facilities))
-    , underConstruction(std::move(other.underConstruction))
-    , facilityOptions(std::move(other.facilityOptions))
+    , operationalCounts(std::move(other.operationalCounts))
+    , completionOrder(std::move(other.completionOrder))
+    , constructionTypes(std::move(other.constructionTypes))
+    , constructionTimeLeft(std::move(other.constructionTimeLeft))
     , life_quality_score(other.life_quality_score)
     , economy_score(other.economy_score)
     , environment_score(other.environment_score)
+    , clock(other.clock)
+    , recordCompletions(false)
+    , recentCompletions()
      {
-    
-    // Nullify moved-from object's pointers
-    other.selectionPolicy = nullptr;
-    //other.settlement = nullptr;
 }
 
-const vector<Facility*> &Plan::getConstruction() const {
-    return underConstruction;
+vector<Facility> Plan::getConstruction(const FacilityCatalog &facilityOptions, long long currentStep) const {
+    vector<Facility> result;
+    result.reserve(constructionTypes.size());
+    // The same countdown catchUp would apply
+    int lag = clock < currentStep ? static_cast<int>(currentStep - clock) : 0;
+    for (size_t i = 0; i < constructionTypes.size(); i++) {
+        int timeLeft = constructionTimeLeft[i] > 0 ? constructionTimeLeft[i] - lag : constructionTimeLeft[i];
+        result.emplace_back(facilityOptions[constructionTypes[i]], settlement->getName(), FacilityStatus::UNDER_CONSTRUCTIONS, timeLeft);
+    }
+    return result;
 }
 
-const string Plan::getSelectionPolicy() const
+int Plan::getPolicyId() const
 {
-    string str = selectionPolicy->toString();
+    return policyId;
+}
 
-    if(str == "NaiveSelection")
-        return "nve";
-    else if(str == "BalancedSelection")
-        return "bal";
-    else if (str == "EconomySelection")
-        return "eco";
-    else if (str == "SustainabilitySelection")
-        return "env";
-    return str; 
+const string &Plan::getSelectionPolicy() const
+{
+    return PolicyRegistry::getShortName(policyId);
 }
 
 //RABIN SHIT
 
 
-SelectionPolicy *Plan::getPolicy() const
+const SelectionPolicy *Plan::getPolicy() const
 {
-    return selectionPolicy;
+    return &selectionPolicy.get();
 }
 
 const string &Plan::getSettlement() const
 {
-    return settlement.getName();
+    return settlement->getName();
 }
 
 
@@ -0,0 +1,97 @@
+#include "PolicyRegistry.h"
+#include <stdexcept>
+
+const int PolicyRegistry::NAIVE;
+const int PolicyRegistry::BALANCED;
+const int PolicyRegistry::ECONOMY;
+const int PolicyRegistry::SUSTAINABILITY;
+const int PolicyRegistry::HORIZON;
+
+static PolicyVariant createNaive(int, int, int)
+{
+    return NaiveSelection();
+}
+
+static PolicyVariant createBalanced(int lifeQualityScore, int economyScore, int environmentScore)
+{
+    return BalancedSelection(lifeQualityScore, economyScore, environmentScore);
+}
+
+static PolicyVariant createEconomy(int, int, int)
+{
+    return EconomySelection();
+}
+
+static PolicyVariant createSustainability(int, int, int)
+{
+    return SustainabilitySelection();
+}
+
+static PolicyVariant createHorizon(int lifeQualityScore, int economyScore, int environmentScore)
+{
+    return HorizonSelection(lifeQualityScore, economyScore, environmentScore);
+}
+
+// Registered in the order of the id constants
+PolicyRegistry::Table::Table() : entries(), byShortName()
+{
+    const Entry builtIn[] = {
+        {"nve", "NaiveSelection", createNaive},
+        {"bal", "BalancedSelection", createBalanced},
+        {"eco", "EconomySelection", createEconomy},
+        {"env", "SustainabilitySelection", createSustainability},
+        {"opt", "HorizonSelection", createHorizon},
+    };
+    for (const Entry &entry : builtIn)
+    {
+        byShortName.emplace(entry.shortName, entries.size());
+        entries.push_back(entry);
+    }
+}
+
+PolicyRegistry::Table &PolicyRegistry::table()
+{
+    static Table instance;
+    return instance;
+}
+
+int PolicyRegistry::registerPolicy(const string &shortName, const string &longName, Factory factory)
+{
+    Table &policies = table();
+    if (policies.byShortName.count(shortName) != 0)
+    {
+        throw std::runtime_error("Selection policy already registered: " + shortName);
+    }
+    int id = policies.entries.size();
+    Entry entry = {shortName, longName, factory};
+    policies.entries.push_back(entry);
+    policies.byShortName.emplace(shortName, id);
+    return id;
+}
+
+int PolicyRegistry::find(const string &shortName)
+{
+    const Table &policies = table();
+    std::unordered_map<string, int>::const_iterator found = policies.byShortName.find(shortName);
+    return found == policies.byShortName.end() ? -1 : found->second;
+}
+
+bool PolicyRegistry::isValid(int id)
+{
+    return id >= 0 && static_cast<size_t>(id) < table().entries.size();
+}
+
+const string &PolicyRegistry::getShortName(int id)
+{
+    return table().entries[id].shortName;
+}
+
+const string &PolicyRegistry::getLongName(int id)
+{
+    return table().entries[id].longName;
+}
+
+PolicyVariant PolicyRegistry::create(int id, int lifeQualityScore, int economyScore, int environmentScore)
+{
+    return table().entries[id].factory(lifeQualityScore, economyScore, environmentScore);
+}
@@ -0,0 +1,162 @@
+#include "PolicyVariant.h"
+#include <new>
+
+PolicyVariant::PolicyVariant(const NaiveSelection &policy) : kind(Kind::NAIVE), naive(policy) {}
+
+PolicyVariant::PolicyVariant(const BalancedSelection &policy) : kind(Kind::BALANCED), balanced(policy) {}
+
+PolicyVariant::PolicyVariant(const EconomySelection &policy) : kind(Kind::ECONOMY), economy(policy) {}
+
+PolicyVariant::PolicyVariant(const SustainabilitySelection &policy) : kind(Kind::SUSTAINABILITY), sustainability(policy) {}
+
+PolicyVariant::PolicyVariant(const HorizonSelection &policy) : kind(Kind::HORIZON), horizon(policy) {}
+
+PolicyVariant::PolicyVariant(SelectionPolicy *policy) : kind(Kind::CUSTOM), custom(policy)
+{
+    // Keep built-in policies inline even when they arrive through the virtual interface
+    if (NaiveSelection *p = dynamic_cast<NaiveSelection *>(policy)) {
+        kind = Kind::NAIVE;
+        new (&naive) NaiveSelection(*p);
+    }
+    else if (BalancedSelection *p = dynamic_cast<BalancedSelection *>(policy)) {
+        kind = Kind::BALANCED;
+        new (&balanced) BalancedSelection(*p);
+    }
+    else if (EconomySelection *p = dynamic_cast<EconomySelection *>(policy)) {
+        kind = Kind::ECONOMY;
+        new (&economy) EconomySelection(*p);
+    }
+    else if (SustainabilitySelection *p = dynamic_cast<SustainabilitySelection *>(policy)) {
+        kind = Kind::SUSTAINABILITY;
+        new (&sustainability) SustainabilitySelection(*p);
+    }
+    else if (HorizonSelection *p = dynamic_cast<HorizonSelection *>(policy)) {
+        kind = Kind::HORIZON;
+        new (&horizon) HorizonSelection(*p);
+    }
+    else {
+        return;
+    }
+    delete policy;
+}
+
+PolicyVariant::PolicyVariant(const PolicyVariant &other) : kind(other.kind), custom(nullptr)
+{
+    copyFrom(other);
+}
+
+PolicyVariant::PolicyVariant(PolicyVariant &&other) noexcept : kind(other.kind), custom(nullptr)
+{
+    if (kind == Kind::CUSTOM) {
+        custom = other.custom;
+        other.custom = nullptr;
+    }
+    else {
+        copyFrom(other);
+    }
+}
+
+PolicyVariant &PolicyVariant::operator=(const PolicyVariant &other)
+{
+    if (this != &other) {
+        // Clone before releasing the current policy, in case cloning throws
+        PolicyVariant copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+PolicyVariant &PolicyVariant::operator=(PolicyVariant &&other) noexcept
+{
+    if (this != &other) {
+        destroy();
+        kind = other.kind;
+        if (kind == Kind::CUSTOM) {
+            custom = other.custom;
+            other.custom = nullptr;
+        }
+        else {
+            copyFrom(other);
+        }
+    }
+    return *this;
+}
+
+PolicyVariant::~PolicyVariant()
+{
+    destroy();
+}
+
+SelectionPolicy &PolicyVariant::get()
+{
+    return const_cast<SelectionPolicy &>(static_cast<const PolicyVariant &>(*this).get());
+}
+
+const SelectionPolicy &PolicyVariant::get() const
+{
+    switch (kind) {
+        case Kind::NAIVE:
+            return naive;
+        case Kind::BALANCED:
+            return balanced;
+        case Kind::ECONOMY:
+            return economy;
+        case Kind::SUSTAINABILITY:
+            return sustainability;
+        case Kind::HORIZON:
+            return horizon;
+        default:
+            return *custom;
+    }
+}
+
+// Constructs the member of other's kind; kind must already equal other.kind
+void PolicyVariant::copyFrom(const PolicyVariant &other)
+{
+    switch (kind) {
+        case Kind::NAIVE:
+            new (&naive) NaiveSelection(other.naive);
+            break;
+        case Kind::BALANCED:
+            new (&balanced) BalancedSelection(other.balanced);
+            break;
+        case Kind::ECONOMY:
+            new (&economy) EconomySelection(other.economy);
+            break;
+        case Kind::SUSTAINABILITY:
+            new (&sustainability) SustainabilitySelection(other.sustainability);
+            break;
+        case Kind::HORIZON:
+            new (&horizon) HorizonSelection(other.horizon);
+            break;
+        case Kind::CUSTOM:
+            custom = other.custom ? other.custom->clone() : nullptr;
+            break;
+    }
+}
+
+void PolicyVariant::destroy()
+{
+    switch (kind) {
+        case Kind::NAIVE:
+            naive.~NaiveSelection();
+            break;
+        case Kind::BALANCED:
+            balanced.~BalancedSelection();
+            break;
+        case Kind::ECONOMY:
+            economy.~EconomySelection();
+            break;
+        case Kind::SUSTAINABILITY:
+            sustainability.~SustainabilitySelection();
+            break;
+        case Kind::HORIZON:
+            horizon.~HorizonSelection();
+            break;
+        case Kind::CUSTOM:
+            delete custom;
+            break;
+    }
+    kind = Kind::CUSTOM;
+    custom = nullptr;
+}
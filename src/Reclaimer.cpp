@@ -0,0 +1,52 @@
+#include "Reclaimer.h"
+
+Reclaimer::Reclaimer()
+    : mutex()
+    , wakeCv()
+    , pending()
+    , stopping(false)
+    , worker(&Reclaimer::workerLoop, this)
+{
+}
+
+Reclaimer::~Reclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    worker.join();
+}
+
+void Reclaimer::release(std::shared_ptr<void> object)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(object));
+    }
+    wakeCv.notify_one();
+}
+
+void Reclaimer::workerLoop()
+{
+    vector<std::shared_ptr<void>> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeCv.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty())
+            return;
+        batch.swap(pending);
+        // Destroy outside the lock, so release never waits for a teardown
+        lock.unlock();
+        batch.clear();
+        lock.lock();
+    }
+}
+
+Reclaimer &Reclaimer::shared()
+{
+    static Reclaimer reclaimer;
+    return reclaimer;
+}
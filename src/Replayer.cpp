@@ -0,0 +1,393 @@
+#include "Replayer.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include "Simulation.h"
+#include "Action.h"
+#include "Auxiliary.h"
+#include "OutputRedirect.h"
+#include "SimulationImage.h"
+
+extern std::deque<Simulation> undoJournal;
+extern size_t undoDepth;
+
+ReplayReport::ReplayReport()
+    : actions(0), skipped(0), seconds(0), stateHash(0), firstDivergence(-1), divergence(),
+      hasExpectedHash(false), expectedHash(0) {}
+
+namespace {
+
+const char *statusName(ActionStatus status)
+{
+    return status == ActionStatus::COMPLETED ? "COMPLETED" : "ERROR";
+}
+
+bool parseInt(const string &word, int &value)
+{
+    return Auxiliary::parseInt(word.data(), word.size(), value);
+}
+
+void splitWords(const string &line, vector<string> &words)
+{
+    words.clear();
+    size_t i = 0;
+    while (i < line.size())
+    {
+        while (i < line.size() && isspace(static_cast<unsigned char>(line[i])))
+            i++;
+        size_t start = i;
+        while (i < line.size() && !isspace(static_cast<unsigned char>(line[i])))
+            i++;
+        if (i > start)
+            words.emplace_back(line, start, i - start);
+    }
+}
+
+// Both the command names and the names actions log themselves under
+const std::unordered_map<string, ActionCode> &actionNames()
+{
+    static const std::unordered_map<string, ActionCode> names = {
+        {"step", ActionCode::STEP}, {"SimulateStep", ActionCode::STEP},
+        {"plan", ActionCode::ADD_PLAN}, {"Plan", ActionCode::ADD_PLAN},
+        {"settlement", ActionCode::ADD_SETTLEMENT}, {"Settlement", ActionCode::ADD_SETTLEMENT},
+        {"facility", ActionCode::ADD_FACILITY}, {"Facility", ActionCode::ADD_FACILITY},
+        {"planStatus", ActionCode::PLAN_STATUS}, {"PlanStatus", ActionCode::PLAN_STATUS},
+        {"changePolicy", ActionCode::CHANGE_POLICY},
+        {"log", ActionCode::PRINT_LOG}, {"Log", ActionCode::PRINT_LOG},
+        {"close", ActionCode::CLOSE}, {"Close", ActionCode::CLOSE},
+        {"backup", ActionCode::BACKUP}, {"BackupSimulation", ActionCode::BACKUP},
+        {"restore", ActionCode::RESTORE}, {"RestoreSimulation", ActionCode::RESTORE},
+        {"snapshots", ActionCode::SNAPSHOTS}, {"Snapshots", ActionCode::SNAPSHOTS},
+        {"dropSnapshot", ActionCode::DROP_SNAPSHOT}, {"DropSnapshot", ActionCode::DROP_SNAPSHOT},
+        {"undo", ActionCode::UNDO}, {"Undo", ActionCode::UNDO},
+        {"save", ActionCode::SAVE}, {"Save", ActionCode::SAVE},
+        {"load", ActionCode::LOAD}, {"Load", ActionCode::LOAD},
+    };
+    return names;
+}
+
+BaseAction *buildAction(ActionCode code, const vector<string> &words, bool hasStatus, ActionStatus status)
+{
+    size_t arguments = words.size() - 1;
+    int number = 0;
+    switch (code)
+    {
+    case ActionCode::STEP:
+        if (arguments != 1 || !parseInt(words[1], number))
+            return nullptr;
+        return new SimulateStep(number);
+    case ActionCode::ADD_PLAN:
+        if (arguments != 2)
+            return nullptr;
+        return new AddPlan(words[1], words[2]);
+    case ActionCode::ADD_SETTLEMENT:
+        if (arguments != 2 || !parseInt(words[2], number) || number < 0 || number > static_cast<int>(SettlementType::METROPOLIS))
+            return nullptr;
+        return new AddSettlement(words[1], static_cast<SettlementType>(number));
+    case ActionCode::ADD_FACILITY:
+    {
+        int scores[4];
+        if (arguments != 6 || !parseInt(words[2], number) || number < 0 || number > static_cast<int>(FacilityCategory::ENVIRONMENT))
+            return nullptr;
+        for (int i = 0; i < 4; i++)
+        {
+            if (!parseInt(words[3 + i], scores[i]))
+                return nullptr;
+        }
+        return new AddFacility(words[1], static_cast<FacilityCategory>(number), scores[0], scores[1], scores[2], scores[3]);
+    }
+    case ActionCode::PLAN_STATUS:
+        if (arguments != 1 || !parseInt(words[1], number))
+            return nullptr;
+        return new PrintPlanStatus(number);
+    case ActionCode::CHANGE_POLICY:
+        if (arguments != 2 || !parseInt(words[1], number))
+            return nullptr;
+        return new ChangePlanPolicy(number, words[2]);
+    case ActionCode::PRINT_LOG:
+        return arguments == 0 ? new PrintActionsLog() : nullptr;
+    case ActionCode::CLOSE:
+        return arguments == 0 ? new Close() : nullptr;
+    case ActionCode::BACKUP:
+        if (arguments > 1)
+            return nullptr;
+        return new BackupSimulation(arguments == 1 ? words[1] : "");
+    case ActionCode::RESTORE:
+        if (arguments > 1)
+            return nullptr;
+        return new RestoreSimulation(arguments == 1 ? words[1] : "");
+    case ActionCode::SNAPSHOTS:
+        return arguments == 0 ? new PrintSnapshots() : nullptr;
+    case ActionCode::DROP_SNAPSHOT:
+        return arguments == 1 ? new DropSnapshot(words[1]) : nullptr;
+    case ActionCode::UNDO:
+        if (arguments > 1 || (arguments == 1 && !parseInt(words[1], number)))
+            return nullptr;
+        // A failed undo changed nothing, and may have failed only for a shallower journal
+        if (hasStatus && status == ActionStatus::ERROR)
+            return new RecordedAction("Undo " + std::to_string(arguments == 1 ? number : 1), status);
+        return new Undo(arguments == 1 ? number : 1);
+    case ActionCode::SAVE:
+        // Logged, but a replay does not write files
+        if (arguments != 1)
+            return nullptr;
+        return new RecordedAction("Save " + words[1], hasStatus ? status : ActionStatus::COMPLETED);
+    case ActionCode::LOAD:
+        return arguments == 1 ? new LoadSimulation(words[1]) : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+// How far back the undos in a text stream reach, at most: the sum of their counts
+size_t undoReach(const char *data, size_t size)
+{
+    size_t reach = 0;
+    string line;
+    size_t position = 0;
+    while (position < size)
+    {
+        const char *newline = static_cast<const char *>(memchr(data + position, '\n', size - position));
+        size_t end = newline != nullptr ? newline - data : size;
+        size_t first = position;
+        while (first < end && isspace(static_cast<unsigned char>(data[first])))
+            first++;
+        if (end - first >= 4 && (memcmp(data + first, "undo", 4) == 0 || memcmp(data + first, "Undo", 4) == 0))
+        {
+            line.assign(data + first, end - first);
+            bool hasStatus = false;
+            ActionStatus status = ActionStatus::COMPLETED;
+            std::unique_ptr<BaseAction> action(Replayer::parse(line, hasStatus, status));
+            Undo *undo = dynamic_cast<Undo *>(action.get());
+            if (undo != nullptr && undo->getCount() > 0)
+                reach += undo->getCount();
+        }
+        position = end + 1;
+    }
+    return reach;
+}
+
+// Undo goes back to whole copies of the state that the journal took before each action
+// (see Simulation::runUndoable), not by inverse records kept in the log. So a stream
+// that undoes replays only if the journal was kept during the replay too: with --undo
+// off, the replay keeps one deep enough for the stream's undos, and drops it after.
+class ReplayJournal {
+    public:
+        explicit ReplayJournal(size_t reach) : savedDepth(undoDepth)
+        {
+            if (undoDepth == 0)
+                undoDepth = reach;
+        }
+        ~ReplayJournal()
+        {
+            undoDepth = savedDepth;
+            while (undoJournal.size() > undoDepth)
+                undoJournal.pop_front();
+        }
+    private:
+        ReplayJournal(const ReplayJournal &) = delete;
+        ReplayJournal &operator=(const ReplayJournal &) = delete;
+        size_t savedDepth;
+};
+
+}
+
+Replayer::Replayer(Simulation &simulation) : simulation(simulation), capture(nullptr) {}
+
+void Replayer::setCapture(std::ostream *capture)
+{
+    this->capture = capture;
+}
+
+BaseAction *Replayer::parse(const string &line, bool &hasStatus, ActionStatus &status)
+{
+    vector<string> words;
+    splitWords(line, words);
+    hasStatus = false;
+    if (words.size() >= 2 && words.back() == "COMPLETED")
+    {
+        hasStatus = true;
+        status = ActionStatus::COMPLETED;
+        words.pop_back();
+    }
+    else
+    {
+        for (size_t i = 1; i < words.size(); i++)
+        {
+            // "ERROR: <message>" from the log file, or a bare "ERROR" from log
+            if (words[i] == "ERROR:" || (words[i] == "ERROR" && i == words.size() - 1))
+            {
+                hasStatus = true;
+                status = ActionStatus::ERROR;
+                words.resize(i);
+                break;
+            }
+        }
+    }
+    if (words.empty())
+        return nullptr;
+    std::unordered_map<string, ActionCode>::const_iterator found = actionNames().find(words[0]);
+    if (found == actionNames().end())
+        return nullptr;
+    return buildAction(found->second, words, hasStatus, status);
+}
+
+bool Replayer::apply(BaseAction &action, bool hasStatus, ActionStatus status, ReplayReport &report)
+{
+    if (dynamic_cast<Close *>(&action) != nullptr)
+        return false;
+    simulation.perform(action);
+    if (hasStatus && action.getStatus() != status && report.firstDivergence < 0)
+    {
+        report.firstDivergence = report.actions;
+        report.divergence = action.toString() + ": logged " + statusName(status) + ", replayed " + statusName(action.getStatus());
+        if (action.getStatus() == ActionStatus::ERROR)
+            report.divergence += " (" + action.getErrorMsg() + ")";
+    }
+    report.actions++;
+    return true;
+}
+
+void Replayer::replayText(const char *data, size_t size, ReplayReport &report)
+{
+    string line;
+    size_t position = 0;
+    while (position < size)
+    {
+        const char *newline = static_cast<const char *>(memchr(data + position, '\n', size - position));
+        size_t end = newline != nullptr ? newline - data : size;
+        line.assign(data + position, end - position);
+        position = end + 1;
+
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+        bool hasStatus = false;
+        ActionStatus status = ActionStatus::COMPLETED;
+        std::unique_ptr<BaseAction> action(parse(line, hasStatus, status));
+        if (!action)
+        {
+            report.skipped++;
+            continue;
+        }
+        if (!apply(*action, hasStatus, status, report))
+            return;
+    }
+}
+
+ReplayReport Replayer::replayFile(const string &path)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Failed to open replay file: " + path);
+    string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ReplayReport report;
+    if (SimulationImage::isImage(data))
+    {
+        // The snapshot's log is the stream, and its state is where the stream should end
+        Simulation expected(simulation);
+        SimulationImage::load(expected, path);
+        report.hasExpectedHash = true;
+        report.expectedHash = expected.stateHash();
+        ActionLog log(expected.getActionsLog());
+        expected = simulation; // Drop the snapshot's state before replaying
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            OutputRedirect redirect(capture);
+            simulation.open();
+            replayRecords(log, report);
+        }
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report.stateHash = simulation.stateHash();
+        return report;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        ReplayJournal journal(undoReach(data.data(), data.size()));
+        OutputRedirect redirect(capture);
+        simulation.open();
+        replayText(data.data(), data.size(), report);
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.stateHash = simulation.stateHash();
+    return report;
+}
+
+ReplayReport Replayer::replayLog(const ActionLog &log)
+{
+    ReplayReport report;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        OutputRedirect redirect(capture);
+        simulation.open();
+        replayRecords(log, report);
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.stateHash = simulation.stateHash();
+    return report;
+}
+
+// Unlike a transcript, a simulation's log is rewritten by restore, undo and load: what
+// precedes their entry is the history of the state they went to. So replaying what
+// precedes the entry already gets there, and the entry itself is only logged again.
+void Replayer::replayRecords(const ActionLog &log, ReplayReport &report)
+{
+    ActionLog::Reader reader(log);
+    while (!reader.atEnd())
+    {
+        std::unique_ptr<BaseAction> action = reader.next();
+        ActionStatus status = action->getStatus();
+        if (dynamic_cast<RecordedAction *>(action.get()) != nullptr || dynamic_cast<SaveSimulation *>(action.get()) != nullptr)
+        {
+            // Only known by how it printed, or must not write its file again
+            bool hasStatus = false;
+            action.reset(parse(action->toString(), hasStatus, status));
+            if (!action)
+            {
+                report.skipped++;
+                continue;
+            }
+        }
+        if (dynamic_cast<Undo *>(action.get()) != nullptr || dynamic_cast<RestoreSimulation *>(action.get()) != nullptr ||
+            dynamic_cast<LoadSimulation *>(action.get()) != nullptr)
+        {
+            action.reset(new RecordedAction(action->toString(), status));
+        }
+        if (!apply(*action, true, status, report))
+            return;
+    }
+}
+
+void Replayer::printReport(const ReplayReport &report, std::ostream &out)
+{
+    char hash[32];
+    out << "Replayed " << report.actions << " actions in " << report.seconds << " s";
+    if (report.seconds > 0)
+        out << " (" << static_cast<long long>(report.actions / report.seconds) << " actions/s)";
+    out << "\n";
+    if (report.skipped > 0)
+        out << "Skipped " << report.skipped << " lines that are not actions\n";
+    std::snprintf(hash, sizeof(hash), "%016llx", report.stateHash);
+    out << "State hash: " << hash << "\n";
+    if (report.firstDivergence >= 0)
+        out << "First divergence: action " << report.firstDivergence << ": " << report.divergence << "\n";
+    else
+        out << "No divergence from the logged statuses\n";
+    if (report.hasExpectedHash)
+    {
+        std::snprintf(hash, sizeof(hash), "%016llx", report.expectedHash);
+        if (report.expectedHash == report.stateHash)
+            out << "Final state matches the snapshot\n";
+        else
+            out << "Final state differs from the snapshot, whose hash is " << hash << "\n";
+    }
+}
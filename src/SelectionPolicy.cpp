@@ -1,6 +1,10 @@
 #include "SelectionPolicy.h"
+#include "BalanceKernel.h"
 #include <stdexcept>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <sstream>
 #include <iostream>
 #include <bits/stdc++.h>
@@ -12,13 +16,33 @@ using std::vector;
 // ----------------------------------------
 //SelectionPolicy::~SelectionPolicy() = default;
 
+void SelectionPolicy::restoreState(const vector<int> &state) {
+    if (!state.empty()) {
+        throw std::runtime_error("Invalid selection policy state.");
+    }
+}
+
+// State of the policies that only remember their position in a cycle
+static void restoreCyclePosition(const vector<int> &state, int &lastSelectedIndex) {
+    if (state.size() != 1 || state[0] < -1) {
+        throw std::runtime_error("Invalid selection policy state.");
+    }
+    lastSelectedIndex = state[0];
+}
+
+void SelectionPolicy::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    for (int i = 0; i < count; i++) {
+        selected.push_back(facilitiesOptions.indexOf(selectFacility(facilitiesOptions)));
+    }
+}
+
 // ----------------------------------------
 // Derived Class: NaiveSelection
 // ----------------------------------------
 
 NaiveSelection::NaiveSelection() : lastSelectedIndex(-1) {}
 
-const FacilityType& NaiveSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+const FacilityType& NaiveSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
     if (facilitiesOptions.empty()) {
         throw std::runtime_error("No facilities available for selection.");
     }
@@ -27,6 +51,21 @@ const FacilityType& NaiveSelection::selectFacility(const vector<FacilityType>& f
     return facilitiesOptions[lastSelectedIndex];
 }
 
+void NaiveSelection::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    if (count <= 0) {
+        return;
+    }
+    if (facilitiesOptions.empty()) {
+        throw std::runtime_error("No facilities available for selection.");
+    }
+
+    int size = facilitiesOptions.size();
+    for (int i = 0; i < count; i++) {
+        lastSelectedIndex = (lastSelectedIndex + 1) % size;
+        selected.push_back(lastSelectedIndex);
+    }
+}
+
 const string NaiveSelection::toString() const {
     return "NaiveSelection";
 }
@@ -35,44 +74,85 @@ NaiveSelection* NaiveSelection::clone() const {
     return new NaiveSelection(*this); // Copy constructor for cloning
 }
 
+bool NaiveSelection::cyclePosition(int &position) const {
+    position = lastSelectedIndex;
+    return true;
+}
+
+void NaiveSelection::saveState(vector<int> &state) const {
+    state.push_back(lastSelectedIndex);
+}
+
+void NaiveSelection::restoreState(const vector<int> &state) {
+    restoreCyclePosition(state, lastSelectedIndex);
+}
+
 // ----------------------------------------
 // Derived Class: BalancedSelection
 // ----------------------------------------
 
+// Below this size a SIMD scan of the catalog beats walking the balance index
+static const size_t BALANCE_INDEX_MIN_FACILITIES = 256;
+
 BalancedSelection::BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore)
     : LifeQualityScore(LifeQualityScore), EconomyScore(EconomyScore), EnvironmentScore(EnvironmentScore) {}
 
-const FacilityType& BalancedSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+const FacilityType& BalancedSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
     if (facilitiesOptions.empty()) {
         throw std::runtime_error("No facilities available for selection.");
     }
 
-    int bestIndex = 0;
-    double bestBalance = std::numeric_limits<double>::max();
-    vector<int> new_vals = {LifeQualityScore, EconomyScore, EnvironmentScore};
-    
-    for (size_t i = 0; i < facilitiesOptions.size(); i++) {
-        const FacilityType& facility = facilitiesOptions[i];
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
 
-        new_vals[0] = facility.getLifeQualityScore() + LifeQualityScore;
-        new_vals[1] = facility.getEconomyScore() + EconomyScore;
-        new_vals[2] = facility.getEnvironmentScore() + EnvironmentScore;
+void BalancedSelection::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    if (count <= 0) {
+        return;
+    }
+    if (facilitiesOptions.empty()) {
+        throw std::runtime_error("No facilities available for selection.");
+    }
 
-        int balance = *max_element(new_vals.begin(), new_vals.end());
-        balance -= *min_element(new_vals.begin(), new_vals.end());
+    for (int i = 0; i < count; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
 
-        // Choose the facility with the best balance (smallest balance value)
-        if (balance < bestBalance) {
-            bestBalance = balance;
-            bestIndex = i;
+// Picks from a non-empty catalog and adds the pick to the running scores
+int BalancedSelection::selectIndex(const FacilityCatalog& facilitiesOptions) {
+    // Choose the first facility with the best balance (smallest max - min of the new scores).
+    // Large catalogs are searched through their index instead of scanned.
+    int bestIndex;
+    if (facilitiesOptions.size() >= BALANCE_INDEX_MIN_FACILITIES) {
+        bestIndex = facilitiesOptions.getBalanceIndex().findMostBalanced(LifeQualityScore, EconomyScore, EnvironmentScore);
+    }
+    else {
+        // The score columns are contiguous within each chunk, so the kernel scans them a
+        // chunk at a time and a later chunk wins only with a strictly better balance
+        const CowVector<int> &life = facilitiesOptions.getLifeQualityScores();
+        const CowVector<int> &economy = facilitiesOptions.getEconomyScores();
+        const CowVector<int> &environment = facilitiesOptions.getEnvironmentScores();
+        bestIndex = -1;
+        int bestBalance = 0;
+        for (size_t chunk = 0; chunk < life.chunkCount(); chunk++) {
+            int index = static_cast<int>(chunk * CowVector<int>::CHUNK_SIZE)
+                      + BalanceKernel::findMostBalanced(life.chunkData(chunk), economy.chunkData(chunk), environment.chunkData(chunk),
+                                                        life.chunkLength(chunk), LifeQualityScore, EconomyScore, EnvironmentScore);
+            int a = LifeQualityScore + life[index];
+            int b = EconomyScore + economy[index];
+            int c = EnvironmentScore + environment[index];
+            int balance = std::max(a, std::max(b, c)) - std::min(a, std::min(b, c));
+            if (bestIndex < 0 || balance < bestBalance) {
+                bestIndex = index;
+                bestBalance = balance;
+            }
         }
-
     }
     LifeQualityScore += facilitiesOptions[bestIndex].getLifeQualityScore();
     EconomyScore += facilitiesOptions[bestIndex].getEconomyScore();
     EnvironmentScore += facilitiesOptions[bestIndex].getEnvironmentScore();
 
-    return facilitiesOptions[bestIndex];
+    return bestIndex;
 }
 
 const string BalancedSelection::toString() const {
@@ -84,26 +164,58 @@ BalancedSelection* BalancedSelection::clone() const {
     return new BalancedSelection(*this); // Copy constructor for cloning
 }
 
+void BalancedSelection::saveState(vector<int> &state) const {
+    state.push_back(LifeQualityScore);
+    state.push_back(EconomyScore);
+    state.push_back(EnvironmentScore);
+}
+
+void BalancedSelection::restoreState(const vector<int> &state) {
+    if (state.size() != 3) {
+        throw std::runtime_error("Invalid selection policy state.");
+    }
+    LifeQualityScore = state[0];
+    EconomyScore = state[1];
+    EnvironmentScore = state[2];
+}
+
 // ----------------------------------------
 // Derived Class: EconomySelection
 // ----------------------------------------
 
 EconomySelection::EconomySelection() : lastSelectedIndex(-1) {}
 
-const FacilityType& EconomySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+const FacilityType& EconomySelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    if (facilitiesOptions.empty()) {
+        throw std::runtime_error("No facilities available for selection.");
+    }
+
+    // The catalog only appends, so the position of the last pick stays valid as it grows
+    const CowVector<int> &economyFacilities = facilitiesOptions.getCategory(FacilityCategory::ECONOMY);
+    if (economyFacilities.empty()) {
+        throw std::runtime_error("No economy facilities available for selection.");
+    }
+    lastSelectedIndex = (lastSelectedIndex + 1) % economyFacilities.size();
+    return facilitiesOptions[economyFacilities[lastSelectedIndex]];
+}
+
+void EconomySelection::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    if (count <= 0) {
+        return;
+    }
     if (facilitiesOptions.empty()) {
         throw std::runtime_error("No facilities available for selection.");
     }
 
-    bool found = false;
-    int index = lastSelectedIndex;
-    while (!found) {
-        index = (index + 1) % facilitiesOptions.size();
-        FacilityType curr = facilitiesOptions[index];
-        found = (curr.getCategory() == FacilityCategory::ECONOMY);
+    const CowVector<int> &economyFacilities = facilitiesOptions.getCategory(FacilityCategory::ECONOMY);
+    if (economyFacilities.empty()) {
+        throw std::runtime_error("No economy facilities available for selection.");
+    }
+    int size = economyFacilities.size();
+    for (int i = 0; i < count; i++) {
+        lastSelectedIndex = (lastSelectedIndex + 1) % size;
+        selected.push_back(economyFacilities[lastSelectedIndex]);
     }
-    lastSelectedIndex = index;
-    return facilitiesOptions[index];
 }
 
 const string EconomySelection::toString() const {
@@ -114,26 +226,56 @@ EconomySelection* EconomySelection::clone() const {
     return new EconomySelection(*this); // Copy constructor for cloning
 }
 
+bool EconomySelection::cyclePosition(int &position) const {
+    position = lastSelectedIndex;
+    return true;
+}
+
+void EconomySelection::saveState(vector<int> &state) const {
+    state.push_back(lastSelectedIndex);
+}
+
+void EconomySelection::restoreState(const vector<int> &state) {
+    restoreCyclePosition(state, lastSelectedIndex);
+}
+
 // ----------------------------------------
 // Derived Class: SustainabilitySelection
 // ----------------------------------------
 
 SustainabilitySelection::SustainabilitySelection() : lastSelectedIndex(-1) {}
 
-const FacilityType& SustainabilitySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+const FacilityType& SustainabilitySelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    if (facilitiesOptions.empty()) {
+        throw std::runtime_error("No facilities available for selection.");
+    }
+
+    // The catalog only appends, so the position of the last pick stays valid as it grows
+    const CowVector<int> &environmentFacilities = facilitiesOptions.getCategory(FacilityCategory::ENVIRONMENT);
+    if (environmentFacilities.empty()) {
+        throw std::runtime_error("No environment facilities available for selection.");
+    }
+    lastSelectedIndex = (lastSelectedIndex + 1) % environmentFacilities.size();
+    return facilitiesOptions[environmentFacilities[lastSelectedIndex]];
+}
+
+void SustainabilitySelection::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    if (count <= 0) {
+        return;
+    }
     if (facilitiesOptions.empty()) {
         throw std::runtime_error("No facilities available for selection.");
     }
 
-    bool found = false;
-    int index = lastSelectedIndex;
-    while (!found) {
-        index = (index + 1) % facilitiesOptions.size();
-        FacilityType curr = facilitiesOptions[index];
-        found = (curr.getCategory() == FacilityCategory::ENVIRONMENT);
+    const CowVector<int> &environmentFacilities = facilitiesOptions.getCategory(FacilityCategory::ENVIRONMENT);
+    if (environmentFacilities.empty()) {
+        throw std::runtime_error("No environment facilities available for selection.");
+    }
+    int size = environmentFacilities.size();
+    for (int i = 0; i < count; i++) {
+        lastSelectedIndex = (lastSelectedIndex + 1) % size;
+        selected.push_back(environmentFacilities[lastSelectedIndex]);
     }
-    lastSelectedIndex = index;
-    return facilitiesOptions[index];
 }
 
 const string SustainabilitySelection::toString() const {
@@ -143,3 +285,301 @@ const string SustainabilitySelection::toString() const {
 SustainabilitySelection* SustainabilitySelection::clone() const {
     return new SustainabilitySelection(*this); // Copy constructor for cloning
 }
+
+bool SustainabilitySelection::cyclePosition(int &position) const {
+    position = lastSelectedIndex;
+    return true;
+}
+
+void SustainabilitySelection::saveState(vector<int> &state) const {
+    state.push_back(lastSelectedIndex);
+}
+
+void SustainabilitySelection::restoreState(const vector<int> &state) {
+    restoreCyclePosition(state, lastSelectedIndex);
+}
+
+// ----------------------------------------
+// Derived Class: HorizonSelection
+// ----------------------------------------
+
+namespace {
+    struct HorizonSettings {
+        int horizon;
+        int lifeQualityWeight;
+        int economyWeight;
+        int environmentWeight;
+    };
+    HorizonSettings defaultHorizonSettings = {100, 1, 1, 1};
+
+    // Searches already made. The objective only sees the totals through their
+    // differences, so plans whose totals differ by the same amount in every score share
+    // a search. Plans are stepped in parallel, so the table is locked.
+    //   catalog version, horizon, weights (3), free slots, life - economy, life - environment
+    typedef std::tuple<unsigned long long, int, int, int, int, int, long long, long long> HorizonKey;
+    std::map<HorizonKey, vector<int>> horizonSearches;
+    std::mutex horizonSearchesMutex;
+    const size_t HORIZON_SEARCHES_MAX = 4096;
+
+    // Search limits: facilities tried at each build, and partial plans kept per round
+    const size_t HORIZON_CANDIDATES_PER_ORDER = 2;
+    const size_t HORIZON_BEAM_WIDTH = 8;
+
+    // A partial plan for the free slots: when each slot is next free (past the horizon
+    // once nothing more fits), what the builds so far add, and each slot's first build
+    struct HorizonNode {
+        vector<int> slotTimes;
+        long long lifeQuality;
+        long long economy;
+        long long environment;
+        vector<int> firstPicks;
+        double estimate;
+    };
+}
+
+// Weighted sum of the totals less their spread, so that the weights pull the scores up
+// and the spread keeps them together, as BalancedSelection does
+static long long horizonObjective(long long lifeQuality, long long economy, long long environment,
+                                  int lifeQualityWeight, int economyWeight, int environmentWeight) {
+    long long spread = std::max(lifeQuality, std::max(economy, environment))
+                     - std::min(lifeQuality, std::min(economy, environment));
+    return lifeQualityWeight * lifeQuality + economyWeight * economy + environmentWeight * environment - spread;
+}
+
+// The facilities the search tries: for each of the weighted score and the three single
+// scores, the ones that add most per step of building. Others are dominated for at least
+// the score they are best at. Only facilities that finish within the horizon qualify;
+// cost 0 never finishes. In catalog order.
+static vector<int> horizonCandidates(const FacilityCatalog& facilitiesOptions, int horizon,
+                                     int lifeQualityWeight, int economyWeight, int environmentWeight) {
+    const CowVector<int> &life = facilitiesOptions.getLifeQualityScores();
+    const CowVector<int> &economy = facilitiesOptions.getEconomyScores();
+    const CowVector<int> &environment = facilitiesOptions.getEnvironmentScores();
+    vector<int> eligible;
+    for (size_t i = 0; i < facilitiesOptions.size(); i++) {
+        int cost = facilitiesOptions[i].getCost();
+        if (cost >= 1 && cost <= horizon) {
+            eligible.push_back(i);
+        }
+    }
+
+    vector<int> candidates;
+    for (int order = 0; order < 4; order++) {
+        auto value = [&](int i) -> long long {
+            switch (order) {
+                case 0: return static_cast<long long>(lifeQualityWeight) * life[i] + static_cast<long long>(economyWeight) * economy[i]
+                             + static_cast<long long>(environmentWeight) * environment[i];
+                case 1: return life[i];
+                case 2: return economy[i];
+                default: return environment[i];
+            }
+        };
+        // Per step: a/ca > b/cb compared without dividing; ties to the lower index
+        vector<int> ranked(eligible);
+        size_t keep = std::min(HORIZON_CANDIDATES_PER_ORDER, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), [&](int a, int b) {
+            long double left = static_cast<long double>(value(a)) * facilitiesOptions[b].getCost();
+            long double right = static_cast<long double>(value(b)) * facilitiesOptions[a].getCost();
+            return left > right || (left == right && a < b);
+        });
+        candidates.insert(candidates.end(), ranked.begin(), ranked.begin() + keep);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+// Beam search over the builds of the free slots. Each round, every kept plan fills its
+// earliest free slot with each candidate that still finishes within the horizon, or
+// closes the slot if none does. Plans are ranked by the objective of the totals so far
+// plus what their remaining slot time could add at the best candidate's rate; the best
+// finished plan's first builds are the picks, one per slot.
+static vector<int> searchHorizon(const FacilityCatalog& facilitiesOptions, int horizon,
+                                 int lifeQualityWeight, int economyWeight, int environmentWeight,
+                                 int slots, long long lifeQualityScore, long long economyScore, long long environmentScore) {
+    vector<int> candidates = horizonCandidates(facilitiesOptions, horizon, lifeQualityWeight, economyWeight, environmentWeight);
+    if (candidates.empty()) {
+        // Nothing finishes within the horizon: take the quickest build that finishes at all
+        int quickest = -1;
+        for (size_t i = 0; i < facilitiesOptions.size(); i++) {
+            int cost = facilitiesOptions[i].getCost();
+            if (cost >= 1 && (quickest < 0 || cost < facilitiesOptions[quickest].getCost())) {
+                quickest = i;
+            }
+        }
+        return vector<int>(slots, quickest < 0 ? 0 : quickest);
+    }
+
+    double bestRate = 0;
+    for (int i : candidates) {
+        long long value = static_cast<long long>(lifeQualityWeight) * facilitiesOptions[i].getLifeQualityScore()
+                        + static_cast<long long>(economyWeight) * facilitiesOptions[i].getEconomyScore()
+                        + static_cast<long long>(environmentWeight) * facilitiesOptions[i].getEnvironmentScore();
+        bestRate = std::max(bestRate, static_cast<double>(value) / facilitiesOptions[i].getCost());
+    }
+    auto objective = [&](const HorizonNode &node) {
+        return horizonObjective(lifeQualityScore + node.lifeQuality, economyScore + node.economy, environmentScore + node.environment,
+                                lifeQualityWeight, economyWeight, environmentWeight);
+    };
+
+    vector<HorizonNode> beam(1, HorizonNode{vector<int>(slots, 0), 0, 0, 0, vector<int>(slots, -1), 0.0});
+    vector<HorizonNode> next;
+    bool haveBest = false;
+    HorizonNode best = beam[0];
+    long long bestValue = 0;
+    while (!beam.empty()) {
+        next.clear();
+        for (const HorizonNode &node : beam) {
+            int slot = std::min_element(node.slotTimes.begin(), node.slotTimes.end()) - node.slotTimes.begin();
+            bool built = false;
+            for (int i : candidates) {
+                const FacilityType &facility = facilitiesOptions[i];
+                if (node.slotTimes[slot] + facility.getCost() > horizon) {
+                    continue;
+                }
+                HorizonNode child = node;
+                child.slotTimes[slot] += facility.getCost();
+                child.lifeQuality += facility.getLifeQualityScore();
+                child.economy += facility.getEconomyScore();
+                child.environment += facility.getEnvironmentScore();
+                if (child.firstPicks[slot] < 0) {
+                    child.firstPicks[slot] = i;
+                }
+                next.push_back(std::move(child));
+                built = true;
+            }
+            if (!built) {
+                HorizonNode child = node;
+                child.slotTimes[slot] = horizon + 1;
+                if (*std::min_element(child.slotTimes.begin(), child.slotTimes.end()) > horizon) {
+                    long long value = objective(child);
+                    if (!haveBest || value > bestValue) {
+                        haveBest = true;
+                        best = std::move(child);
+                        bestValue = value;
+                    }
+                }
+                else {
+                    next.push_back(std::move(child));
+                }
+            }
+        }
+
+        for (HorizonNode &node : next) {
+            long long remaining = 0;
+            for (int time : node.slotTimes) {
+                remaining += std::max(0, horizon - time);
+            }
+            node.estimate = objective(node) + static_cast<double>(remaining) * bestRate;
+        }
+        // Stable, so equal plans keep the order they were found in and the search is
+        // the same on every run
+        size_t keep = std::min(HORIZON_BEAM_WIDTH, next.size());
+        std::stable_sort(next.begin(), next.end(), [](const HorizonNode &a, const HorizonNode &b) {
+            return a.estimate > b.estimate;
+        });
+        next.erase(next.begin() + keep, next.end());
+        beam.swap(next);
+    }
+    return best.firstPicks;
+}
+
+HorizonSelection::HorizonSelection() : HorizonSelection(0, 0, 0) {}
+
+HorizonSelection::HorizonSelection(int lifeQualityScore, int economyScore, int environmentScore)
+    : horizon(defaultHorizonSettings.horizon)
+    , lifeQualityWeight(defaultHorizonSettings.lifeQualityWeight)
+    , economyWeight(defaultHorizonSettings.economyWeight)
+    , environmentWeight(defaultHorizonSettings.environmentWeight)
+    , LifeQualityScore(lifeQualityScore)
+    , EconomyScore(economyScore)
+    , EnvironmentScore(environmentScore) {}
+
+void HorizonSelection::configure(int horizon, int lifeQualityWeight, int economyWeight, int environmentWeight) {
+    if (horizon <= 0) {
+        throw std::runtime_error("The horizon must be at least one step.");
+    }
+    HorizonSettings settings = {horizon, lifeQualityWeight, economyWeight, environmentWeight};
+    defaultHorizonSettings = settings;
+}
+
+const FacilityType& HorizonSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    vector<int> selected;
+    selectFacilities(facilitiesOptions, 1, selected);
+    return facilitiesOptions[selected[0]];
+}
+
+void HorizonSelection::selectFacilities(const FacilityCatalog& facilitiesOptions, int count, vector<int> &selected) {
+    if (count <= 0) {
+        return;
+    }
+    if (facilitiesOptions.empty()) {
+        throw std::runtime_error("No facilities available for selection.");
+    }
+
+    vector<int> picks = search(facilitiesOptions, count);
+    for (int index : picks) {
+        selected.push_back(index);
+        LifeQualityScore += facilitiesOptions[index].getLifeQualityScore();
+        EconomyScore += facilitiesOptions[index].getEconomyScore();
+        EnvironmentScore += facilitiesOptions[index].getEnvironmentScore();
+    }
+}
+
+// Picks for count free slots of a non-empty catalog, from the shared table if the same
+// search was made before
+vector<int> HorizonSelection::search(const FacilityCatalog& facilitiesOptions, int count) const {
+    HorizonKey key(facilitiesOptions.getVersion(), horizon, lifeQualityWeight, economyWeight, environmentWeight, count,
+                   static_cast<long long>(LifeQualityScore) - EconomyScore,
+                   static_cast<long long>(LifeQualityScore) - EnvironmentScore);
+    {
+        std::lock_guard<std::mutex> lock(horizonSearchesMutex);
+        std::map<HorizonKey, vector<int>>::const_iterator found = horizonSearches.find(key);
+        if (found != horizonSearches.end()) {
+            return found->second;
+        }
+    }
+
+    // Search outside the lock; plans racing on the same key find the same answer
+    vector<int> picks = searchHorizon(facilitiesOptions, horizon, lifeQualityWeight, economyWeight, environmentWeight,
+                                      count, LifeQualityScore, EconomyScore, EnvironmentScore);
+    {
+        std::lock_guard<std::mutex> lock(horizonSearchesMutex);
+        if (horizonSearches.size() >= HORIZON_SEARCHES_MAX) {
+            horizonSearches.clear();
+        }
+        horizonSearches.emplace(key, picks);
+    }
+    return picks;
+}
+
+const string HorizonSelection::toString() const {
+    return "HorizonSelection";
+}
+
+HorizonSelection* HorizonSelection::clone() const {
+    return new HorizonSelection(*this); // Copy constructor for cloning
+}
+
+void HorizonSelection::saveState(vector<int> &state) const {
+    state.push_back(horizon);
+    state.push_back(lifeQualityWeight);
+    state.push_back(economyWeight);
+    state.push_back(environmentWeight);
+    state.push_back(LifeQualityScore);
+    state.push_back(EconomyScore);
+    state.push_back(EnvironmentScore);
+}
+
+void HorizonSelection::restoreState(const vector<int> &state) {
+    if (state.size() != 7 || state[0] <= 0) {
+        throw std::runtime_error("Invalid selection policy state.");
+    }
+    horizon = state[0];
+    lifeQualityWeight = state[1];
+    economyWeight = state[2];
+    environmentWeight = state[3];
+    LifeQualityScore = state[4];
+    EconomyScore = state[5];
+    EnvironmentScore = state[6];
+}
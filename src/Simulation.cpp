@@ -1,58 +1,92 @@
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
 #include <stdexcept>
 #include "Simulation.h"
 #include "Auxiliary.h"
+#include "ConfigLoader.h"
 #include "Settlement.h"
 #include "Facility.h"
-#include "SelectionPolicy.h"
 #include "Action.h"
 #include "Plan.h"
+#include "ThreadPool.h"
+#include "LogWriter.h"
 #include <sstream>
 using namespace std;
 
 extern Simulation *backup;
+extern std::map<string, Simulation> snapshots;
+extern std::deque<Simulation> undoJournal;
+extern size_t undoDepth;
 
-// Constructor: Parse Config File
-Simulation::Simulation(const string &configFilePath) : isRunning(false), // Initialize to false
-      planCounter(0),   // Initialize to 0
-      actionsLog(),     // Default initialize as an empty vector
-      settlements(),    // Default initialize as an empty vector
-      facilitiesOptions(), // Default initialize as an empty vector
-      plans()            {
-    std::ifstream configFile(configFilePath);
-    if (!configFile.is_open()) {
-        throw std::runtime_error("Failed to open config file: " + configFilePath);
-    }
+// Below this many plans a step is cheaper than waking the worker threads
+static const size_t PARALLEL_STEP_THRESHOLD = 64;
 
-    string line;
-    while (std::getline(configFile, line)) {
-        // Trim leading/trailing whitespaces
-        line.erase(0, line.find_first_not_of(" \t\n\r"));
-        line.erase(line.find_last_not_of(" \t\n\r") + 1);
+typedef std::pair<long long, int> Wake;
 
-        // Skip empty lines or comments
-        if (line.empty() || line[0] == '#')
+// The calendar is a binary min-heap kept in a CowVector, so that after a backup only
+// the chunks along a sift path are copied
+static void pushWake(CowVector<Wake> &calendar, const Wake &wake)
+{
+    calendar.push_back(wake);
+    size_t i = calendar.size() - 1;
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        Wake parentWake = calendar[parent];
+        if (!(wake < parentWake))
+            break;
+        calendar.mutate(i) = parentWake;
+        i = parent;
+    }
+    calendar.mutate(i) = wake;
+}
+
+static Wake popWake(CowVector<Wake> &calendar)
+{
+    Wake top = calendar[0];
+    Wake last = calendar.back();
+    calendar.pop_back();
+    size_t count = calendar.size();
+    if (count > 0)
+    {
+        size_t i = 0;
+        while (2 * i + 1 < count)
         {
-            continue;
+            size_t child = 2 * i + 1;
+            if (child + 1 < count && calendar[child + 1] < calendar[child])
+                child++;
+            Wake childWake = calendar[child];
+            if (!(childWake < last))
+                break;
+            calendar.mutate(i) = childWake;
+            i = child;
         }
-        
-        actionHandler(line); // Handle the full line of input        
-    }
-    
-    for (BaseAction *action : actionsLog)
-    {
-        if(action)
-           delete action;
-        action=nullptr;
+        calendar.mutate(i) = last;
     }
+    return top;
+}
 
+// Constructor: Parse Config File
+Simulation::Simulation(const string &configFilePath) : isRunning(false), // Initialize to false
+      planCounter(0),   // Initialize to 0
+      actionsLog(),     // Default initialize as an empty vector
+      settlements(),    // Default initialize as an empty vector
+      facilitiesOptions(std::make_shared<FacilityCatalog>()),
+      settlementIndex(),
+      plans(),
+      currentStep(0),
+      calendar()         {
+    ConfigLoader::load(*this, configFilePath);
     actionsLog.clear();
     planCounter = plans.size();
-    configFile.close();
 }
 
 
@@ -65,193 +99,520 @@ void Simulation::start() {
         while (isRunning)
     {
         std::cout << "Type an action (or 'close' to stop): ";
-        std::getline(std::cin, action); // Use getline to capture the entire input line
+        if (!std::getline(std::cin, action)) // Use getline to capture the entire input line
+        {
+            action = "close"; // End of input closes the simulation
+        }
 
         actionHandler(action); // Handle the full line of input
     }
 
     delete backup;
     backup = nullptr;
+    snapshots.clear();
+    undoJournal.clear();
 
     isRunning = false; // Mark simulation as stopped
 }
 
 // Add a plan to the simulation
-void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy) {
-    plans.emplace_back(planCounter, settlement, selectionPolicy, facilitiesOptions);
+void Simulation::addPlan(const Settlement &settlement, int policyId) {
+    plans.push_back(Plan(planCounter, settlements[*settlementIndex.find(settlement.getName())], policyId, currentStep));
     planCounter++;
+    scheduleWake(plans.size() - 1);
+}
+
+// Puts the plan back on the calendar at the step of its next selection or completion
+void Simulation::scheduleWake(int planIndex) {
+    long long wake = plans[planIndex].nextEventStep();
+    if (wake >= 0)
+    {
+        pushWake(calendar, Wake(wake, planIndex));
+    }
 }
 
 // Add an action to the simulation
+// Commands run once the simulation has started also go to the log file, if any
+void Simulation::addAction(const BaseAction &action) {
+    actionsLog.append(action);
+    LogWriter *logWriter = LogWriter::shared();
+    if (isRunning && logWriter != nullptr)
+    {
+        string line = action.toString();
+        if (action.getStatus() == ActionStatus::COMPLETED)
+        {
+            line += " COMPLETED";
+        }
+        else
+        {
+            line += " ERROR: " + action.getErrorMsg();
+        }
+        logWriter->submit(std::move(line));
+    }
+}
+
 void Simulation::addAction(BaseAction *action) {
-    actionsLog.push_back(action);
+    actionsLog.append(*action);
+    delete action;
 }
 
 // Add a settlement to the simulation
+// Takes ownership of the settlement if it is added
 bool Simulation::addSettlement(Settlement *settlement) {
-    if (isSettlementExists(settlement->getName())) {
+    if (!settlementIndex.insert(settlement->getName(), settlements.size())) {
         return false; // Settlement already exists
     }
-    settlements.push_back(settlement);
+    settlements.push_back(std::shared_ptr<const Settlement>(settlement));
     return true;
 }
 
-Settlement &Simulation::getSettlement(const string &settlementName)
+const Settlement &Simulation::getSettlement(const string &settlementName)
 {
-    for(Settlement *stl : settlements)
-    {
-        if(stl->getName() == settlementName)
-            return *stl;
-    }
+    const int *found = settlementIndex.find(settlementName);
+    if (found == nullptr)
         throw std::runtime_error("Settlement not found");
+    return *settlements[*found];
 } 
 
 Plan &Simulation::getPlan(const int planID)
 {
 if (planID < 0 || static_cast<size_t>(planID) >= plans.size()) 
     {
-        std::cout << "Invalid plan ID" << std::endl;
+        throw std::runtime_error("Invalid plan ID");
     }
+    // Plans off the calendar lag behind; bring their timers up to date
+    Plan &plan = plans.mutate(planID);
+    plan.catchUp(currentStep);
     // Return the plan by reference
-    return plans[planID];
+    return plan;
 } 
 
+const Plan &Simulation::getPlan(const int planID) const
+{
+    if (planID < 0 || static_cast<size_t>(planID) >= plans.size())
+    {
+        throw std::runtime_error("Invalid plan ID");
+    }
+    return plans[planID];
+}
+
 // Add a facility to the simulation
 bool Simulation::addFacility(FacilityType facility) {
-    for (const auto &existingFacility : facilitiesOptions) {
-        if (existingFacility.getName() == facility.getName()) {
-            return false; // Facility already exists
-        }
+    if (facilitiesOptions->contains(facility.getName())) {
+        return false; // The facility already exists
     }
-    facilitiesOptions.push_back(facility);
-    return true;
+    if (facilitiesOptions.use_count() > 1) {
+        // The copy shares the catalog's chunks; add copies only those it writes to
+        facilitiesOptions = std::make_shared<FacilityCatalog>(*facilitiesOptions);
+    }
+    return facilitiesOptions->add(facility);
+}
+
+const FacilityCatalog &Simulation::getFacilitiesOptions() const
+{
+    return *facilitiesOptions;
 }
 
 // Check if a settlement exists
 bool Simulation::isSettlementExists(const string &settlementName) {
-    for (Settlement *settl : settlements)
-    {
-        if (settl->getName() == settlementName)
-        {
-            return true;
-        } 
-    }
-    return false;
+    return settlementIndex.contains(settlementName);
 }
 
 void Simulation::step(){
-    for(Plan &plan : plans)
-    {
-        plan.step();
-    }
+    step(1);
 }
 
-void Simulation::open()
-{
-    isRunning = true;
-}
-
-void Simulation::close()
-{
-    for(Plan &plan: plans)
+// Only plans with an event in the next numOfSteps steps are taken off the calendar;
+// each of them then runs to the target step on its own, skipping the idle stretches.
+// Plans only read the shared catalog and their own settlement, so the due plans can be
+// split between the pool's threads
+void Simulation::step(int numOfSteps){
+    if (numOfSteps <= 0)
+        return;
+
+    long long target = currentStep + numOfSteps;
+    vector<int> due;
+    while (!calendar.empty() && calendar[0].first <= target)
     {
-        plan.printStatus();
+        due.push_back(popWake(calendar).second);
     }
-    isRunning = false;
-}
 
-void Simulation::actionHandler(const std::string &action)
-{
-    std::vector<std::string> words = Auxiliary::parseArguments(action);
+    // Unshare the due plans' chunks here, so the threads below only write to plans they own
+    const FacilityCatalog &catalog = *facilitiesOptions;
+    vector<Plan *> duePlans(due.size());
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        duePlans[i] = &plans.mutate(due[i]);
+    }
 
-    if (words[0] == "log")
+    // A plan whose policy cannot select still reaches the target; the first error, in
+    // calendar order, is reported once every due plan is back on the calendar
+    vector<std::exception_ptr> failures(due.size());
+    ThreadPool &pool = ThreadPool::shared();
+    if (pool.getThreadCount() > 1 && due.size() >= PARALLEL_STEP_THRESHOLD)
+    {
+        pool.parallelFor(due.size(), [&duePlans, &catalog, &failures, target](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                try
+                {
+                    duePlans[i]->advanceTo(target, catalog);
+                }
+                catch (...)
+                {
+                    failures[i] = std::current_exception();
+                }
+            }
+        });
+    }
+    else
     {
-        PrintActionsLog printLog = PrintActionsLog();
-        printLog.act(*this);
-        BaseAction *clonedRestore = printLog.clone();
-        actionsLog.push_back(clonedRestore);
+        for (size_t i = 0; i < due.size(); i++)
+        {
+            try
+            {
+                duePlans[i]->advanceTo(target, catalog);
+            }
+            catch (...)
+            {
+                failures[i] = std::current_exception();
+            }
+        }
     }
 
-    if (words[0] == "settlement")
+    currentStep = target;
+    for (int planIndex : due)
     {
-        SettlementType type;
-        if(words[2] == "0") type = SettlementType::VILLAGE;
-        else if(words[2] == "1") type = SettlementType::CITY;
-        else if(words[2] == "2") type = SettlementType::METROPOLIS;
-        AddSettlement settlemntToBeAdded = AddSettlement(words[1], type);
-        settlemntToBeAdded.act(*this);
-        BaseAction *clonedRestore = settlemntToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        scheduleWake(planIndex);
     }
-    else if (words[0] == "facility")
+    for (const std::exception_ptr &failure : failures)
     {
-        FacilityCategory cat;
-        if(words[2] == "0") cat = FacilityCategory::LIFE_QUALITY;
-        else if(words[2] == "1") cat = FacilityCategory::ECONOMY;
-        else if(words[2] == "2") cat = FacilityCategory::ENVIRONMENT;
-        AddFacility faccilityToBeAdded = AddFacility(words[1], cat, std::stoi(words[3]), std::stoi(words[4]), std::stoi(words[5]), std::stoi(words[6]));
-        faccilityToBeAdded.act(*this);
-        BaseAction *clonedRestore = faccilityToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+}
 
+// Acts and logs like the other actions, and keeps the state from before the action for
+// undo if the action completes. The copy is O(1); what it costs is that the chunks the
+// action changes are copied rather than changed in place (see CowVector).
+// Whole states are journaled instead of inverse records of each action, so replaying
+// an undo needs the journal as well (see Replayer).
+void Simulation::runUndoable(BaseAction &action)
+{
+    if (!isRunning || undoDepth == 0)
+    {
+        // Loading the config file is not undoable
+        action.act(*this);
     }
-        else if (words[0] == "plan")
+    else
     {
-        AddPlan planToBeAdded(words[1], words[2]);
-        planToBeAdded.act(*this);
-        BaseAction *clonedRestore = planToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        Simulation before(*this);
+        action.act(*this);
+        if (action.getStatus() == ActionStatus::COMPLETED)
+        {
+            undoJournal.push_back(std::move(before));
+            if (undoJournal.size() > undoDepth)
+            {
+                undoJournal.pop_front();
+            }
+        }
     }
+    addAction(action);
+}
 
-    else if (words[0] == "planStatus")
+long long Simulation::getCurrentStep() const
+{
+    return currentStep;
+}
+
+unsigned long long Simulation::stateHash() const
+{
+    StateHash hash;
+    hash.add(planCounter);
+    hash.add(currentStep);
+    hash.add(static_cast<long long>(settlements.size()));
+    for (const std::shared_ptr<const Settlement> &settlement : settlements)
     {
-        PrintPlanStatus planStatusToBeAdded = PrintPlanStatus(std::stoi(words[1]));
-        planStatusToBeAdded.act(*this);
-        BaseAction *clonedRestore = planStatusToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        hash.add(settlement->getName());
+        hash.add(static_cast<long long>(settlement->getType()));
     }
-    else if (words[0] == "step")
+    hash.add(static_cast<long long>(facilitiesOptions->size()));
+    for (const FacilityType &facility : *facilitiesOptions)
     {
-        SimulateStep simulateStepToBeAdded = SimulateStep(std::stoi(words[1]));
-        simulateStepToBeAdded.act(*this);
-        BaseAction *clonedRestore = simulateStepToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        hash.add(facility.getName());
+        hash.add(static_cast<long long>(facility.getCategory()));
+        hash.add(facility.getCost());
+        hash.add(facility.getLifeQualityScore());
+        hash.add(facility.getEconomyScore());
+        hash.add(facility.getEnvironmentScore());
+    }
+    hash.add(static_cast<long long>(plans.size()));
+    for (const Plan &plan : plans)
+    {
+        if (plan.getClock() < currentStep)
+        {
+            // Catch up a copy, so that the hash does not depend on how lazy the plan was
+            Plan current(plan);
+            current.catchUp(currentStep);
+            current.addToHash(hash);
+        }
+        else
+        {
+            plan.addToHash(hash);
+        }
     }
-    else if (words[0] == "changePolicy")
+    return hash.get();
+}
+
+void Simulation::perform(BaseAction &action)
+{
+    if (action.changesState())
     {
-        ChangePlanPolicy changePlanPolicyToBeAdded = ChangePlanPolicy(std::stoi(words[1]), words[2]);
-        changePlanPolicyToBeAdded.act(*this);
-        BaseAction *clonedRestore = changePlanPolicyToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        runUndoable(action);
     }
-    else if(words[0] == "close")
+    else
     {
-        Close close = Close();
-        close.act(*this);
+        action.act(*this);
+        addAction(action);
     }
-    else if (words[0] == "restore")
+}
+
+void Simulation::open()
+{
+    isRunning = true;
+}
+
+void Simulation::close()
+{
+    for(const Plan &plan: plans)
     {
-        RestoreSimulation restore = RestoreSimulation();
-        restore.act(*this);
-        BaseAction *clonedRestore = restore.clone();
-        actionsLog.push_back(clonedRestore);
+        plan.printStatus();
     }
+    isRunning = false;
+}
+
+namespace {
+
+// A word of a command line, pointing into the line
+struct Word {
+    const char *data;
+    size_t size;
 
-    else if (words[0] == "backup")
+    string str() const { return string(data, size); }
+};
+
+// More words than any command takes, so longer lines are still caught
+const size_t MAX_WORDS = 8;
+
+// Splits the line into words; returns how many there are, which may exceed MAX_WORDS
+size_t splitWords(const string &line, Word *words)
+{
+    size_t count = 0;
+    size_t i = 0;
+    while (true)
     {
-        BackupSimulation backupSim = BackupSimulation();
-        backupSim.act(*this);
-        BaseAction *clonedRestore = backupSim.clone();
-        actionsLog.push_back(clonedRestore);
+        while (i < line.size() && isspace(static_cast<unsigned char>(line[i])))
+            i++;
+        if (i == line.size())
+            return count;
+        size_t start = i;
+        while (i < line.size() && !isspace(static_cast<unsigned char>(line[i])))
+            i++;
+        if (count < MAX_WORDS)
+            words[count] = Word{line.data() + start, i - start};
+        count++;
     }
+}
 
+bool parseInt(const Word &word, int &value)
+{
+    return Auxiliary::parseInt(word.data, word.size, value);
+}
+
+// One of the digits 0 to last, as settlement types and facility categories are given
+bool parseChoice(const Word &word, int last, int &value)
+{
+    if (word.size != 1 || word.data[0] < '0' || word.data[0] > '0' + last)
+        return false;
+    value = word.data[0] - '0';
+    return true;
+}
+
+// Builds and performs the command's action from its arguments (the words after the
+// keyword); false if an argument is invalid
+typedef bool (*CommandHandler)(Simulation &simulation, const Word *arguments, size_t count);
+
+struct Command {
+    const char *keyword;
+    size_t minArguments;
+    size_t maxArguments;
+    const char *usage;
+    CommandHandler handler;
+};
+
+const Command COMMANDS[] = {
+    {"step", 1, 1, "step <number_of_steps>", [](Simulation &simulation, const Word *arguments, size_t) {
+        int steps;
+        if (!parseInt(arguments[0], steps))
+            return false;
+        SimulateStep action(steps);
+        simulation.perform(action);
+        return true;
+    }},
+    {"plan", 2, 2, "plan <settlement_name> <selection_policy>", [](Simulation &simulation, const Word *arguments, size_t) {
+        AddPlan action(arguments[0].str(), arguments[1].str());
+        simulation.perform(action);
+        return true;
+    }},
+    {"settlement", 2, 2, "settlement <settlement_name> <settlement_type>", [](Simulation &simulation, const Word *arguments, size_t) {
+        int type;
+        if (!parseChoice(arguments[1], static_cast<int>(SettlementType::METROPOLIS), type))
+            return false;
+        AddSettlement action(arguments[0].str(), static_cast<SettlementType>(type));
+        simulation.perform(action);
+        return true;
+    }},
+    {"facility", 6, 6, "facility <facility_name> <category> <price> <lifeq_impact> <eco_impact> <env_impact>", [](Simulation &simulation, const Word *arguments, size_t) {
+        int category;
+        int values[4];
+        if (!parseChoice(arguments[1], static_cast<int>(FacilityCategory::ENVIRONMENT), category))
+            return false;
+        for (int i = 0; i < 4; i++)
+        {
+            if (!parseInt(arguments[2 + i], values[i]))
+                return false;
+        }
+        AddFacility action(arguments[0].str(), static_cast<FacilityCategory>(category), values[0], values[1], values[2], values[3]);
+        simulation.perform(action);
+        return true;
+    }},
+    {"planStatus", 1, 1, "planStatus <plan_id>", [](Simulation &simulation, const Word *arguments, size_t) {
+        int planId;
+        if (!parseInt(arguments[0], planId))
+            return false;
+        PrintPlanStatus action(planId);
+        simulation.perform(action);
+        return true;
+    }},
+    {"changePolicy", 2, 2, "changePolicy <plan_id> <selection_policy>", [](Simulation &simulation, const Word *arguments, size_t) {
+        int planId;
+        if (!parseInt(arguments[0], planId))
+            return false;
+        ChangePlanPolicy action(planId, arguments[1].str());
+        simulation.perform(action);
+        return true;
+    }},
+    {"log", 0, 0, "log", [](Simulation &simulation, const Word *, size_t) {
+        PrintActionsLog action;
+        simulation.perform(action);
+        return true;
+    }},
+    {"close", 0, 0, "close", [](Simulation &simulation, const Word *, size_t) {
+        // Close ends the run and is not logged
+        Close action;
+        action.act(simulation);
+        return true;
+    }},
+    {"backup", 0, 1, "backup [name]", [](Simulation &simulation, const Word *arguments, size_t count) {
+        BackupSimulation action(count == 1 ? arguments[0].str() : "");
+        simulation.perform(action);
+        return true;
+    }},
+    {"restore", 0, 1, "restore [name]", [](Simulation &simulation, const Word *arguments, size_t count) {
+        RestoreSimulation action(count == 1 ? arguments[0].str() : "");
+        simulation.perform(action);
+        return true;
+    }},
+    {"snapshots", 0, 0, "snapshots", [](Simulation &simulation, const Word *, size_t) {
+        PrintSnapshots action;
+        simulation.perform(action);
+        return true;
+    }},
+    {"dropSnapshot", 1, 1, "dropSnapshot <name>", [](Simulation &simulation, const Word *arguments, size_t) {
+        DropSnapshot action(arguments[0].str());
+        simulation.perform(action);
+        return true;
+    }},
+    {"undo", 0, 1, "undo [number_of_actions]", [](Simulation &simulation, const Word *arguments, size_t count) {
+        int actions = 1;
+        if (count == 1 && !parseInt(arguments[0], actions))
+            return false;
+        Undo action(actions);
+        simulation.perform(action);
+        return true;
+    }},
+    {"save", 1, 1, "save <file>", [](Simulation &simulation, const Word *arguments, size_t) {
+        SaveSimulation action(arguments[0].str());
+        simulation.perform(action);
+        return true;
+    }},
+    {"load", 1, 1, "load <file>", [](Simulation &simulation, const Word *arguments, size_t) {
+        LoadSimulation action(arguments[0].str());
+        simulation.perform(action);
+        return true;
+    }},
+};
+
+// Perfect hash of the keywords above into 32 slots: no two of them share a slot, which
+// commandTable checks, so a lookup is one hash and one compare
+const size_t COMMAND_SLOTS = 32;
+
+size_t keywordSlot(const char *keyword, size_t size)
+{
+    return (size * 4 + static_cast<unsigned char>(keyword[0]) + static_cast<unsigned char>(keyword[size - 1]) * 9) % COMMAND_SLOTS;
+}
+
+const Command *const *commandTable()
+{
+    static const Command *const *table = [] {
+        static const Command *slots[COMMAND_SLOTS] = {};
+        for (const Command &command : COMMANDS)
+        {
+            const Command *&slot = slots[keywordSlot(command.keyword, std::strlen(command.keyword))];
+            if (slot != nullptr)
+                throw std::logic_error(string("Command keywords collide: ") + slot->keyword + ", " + command.keyword);
+            slot = &command;
+        }
+        return slots;
+    }();
+    return table;
+}
+
+// The command the word names, or nullptr
+const Command *findCommand(const Word &word)
+{
+    const Command *command = commandTable()[keywordSlot(word.data, word.size)];
+    if (command == nullptr || std::strlen(command->keyword) != word.size || std::memcmp(command->keyword, word.data, word.size) != 0)
+        return nullptr;
+    return command;
+}
+
+}
+
+// Unknown commands are ignored. A known command with the wrong number of arguments, or
+// an argument that is not what it takes, is reported with its usage and not logged.
+void Simulation::actionHandler(const std::string &action)
+{
+    Word words[MAX_WORDS];
+    size_t count = splitWords(action, words);
+    if (count == 0)
+        return;
+    const Command *command = findCommand(words[0]);
+    if (command == nullptr)
+        return;
+    size_t arguments = count - 1;
+    if (arguments < command->minArguments || arguments > command->maxArguments || !command->handler(*this, words + 1, arguments))
+    {
+        std::cout << "Error: Usage: " << command->usage << std::endl;
+    }
 }
 
 void Simulation::printLog() const
 {
-    for (BaseAction *action : actionsLog)
+    ActionLog::Reader reader(actionsLog);
+    while (!reader.atEnd())
     {
-        std::cout << action->toString() << std::endl;
+        std::cout << reader.next()->toString() << std::endl;
     }
 }
 
@@ -261,7 +622,7 @@ int & Simulation::getplanCounter()
     return planCounter;
 }
 
-const vector<BaseAction*> & Simulation::getActionsLog()
+const ActionLog & Simulation::getActionsLog() const
 {
     return actionsLog;
 } 
@@ -270,69 +631,18 @@ const vector<BaseAction*> & Simulation::getActionsLog()
 //RULE OF 5 IMPLEMENTATION
 // ***********************
 
+// Copies share all state with the original (see CowVector), so copying is O(1)
 Simulation::Simulation(const Simulation &other)
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
-      actionsLog(),
-      settlements(),
+      actionsLog(other.actionsLog),
+      settlements(other.settlements),
       facilitiesOptions(other.facilitiesOptions),
-      plans()
+      settlementIndex(other.settlementIndex),
+      plans(other.plans),
+      currentStep(other.currentStep),
+      calendar(other.calendar)
 {
-    // Deep copy actionsLog
-    for (auto *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    for (auto *settlement : other.settlements)
-    {
-        settlements.push_back(new Settlement(*settlement));
-    }
-
-    // Deep copy plans
-    for (const auto &plan : other.plans)
-    {
-        const std::string &settlementName = plan.getSettlement();
-        Settlement *newSettlement = nullptr;
-
-        // Find corresponding settlement
-        for (Settlement *copiedSettlement : settlements)
-        {
-            if (copiedSettlement->getName() == settlementName)
-            {
-                newSettlement = copiedSettlement;
-                break;
-            }
-        }
-
-        // Deep copy facilities
-        std::vector<Facility *> copiedFacilities;
-        for (Facility *facility : plan.getFacilities())
-        {
-            copiedFacilities.push_back(facility->clone());
-        }
-
-        // Deep copy underConstruction
-        std::vector<Facility *> copiedUnderConstruction;
-        for (Facility *facility : plan.getConstruction())
-        {
-            copiedUnderConstruction.push_back(facility->clone());
-        }
-
-        // Reconstruct the Plan
-        plans.emplace_back(
-            plan.getID(),
-            *newSettlement, // Deep-copied settlement
-            plan.getPolicy() ? plan.getPolicy()->clone() : nullptr,
-            facilitiesOptions,
-            plan.getlifeQualityScore(),
-            plan.getEconomyScore(),
-            plan.getEnvironmentScore(),
-            std::move(copiedFacilities),       // Transfer ownership
-            std::move(copiedUnderConstruction) // Transfer ownership
-        );
-    }
 }
 
 Simulation &Simulation::operator=(const Simulation &other)
@@ -342,77 +652,15 @@ Simulation &Simulation::operator=(const Simulation &other)
         return *this; // Prevent self-assignment
     }
 
-    // Cleanup current resources
-    for (BaseAction *action : actionsLog)
-    {
-        delete action;
-    }
-    actionsLog.clear();
-
-    for (Settlement *settlement : settlements)
-    {
-        delete settlement;
-    }
-    settlements.clear();
-
-    plans.clear();
-    facilitiesOptions.clear();
-
-    // Copy basic members
     isRunning = other.isRunning;
     planCounter = other.planCounter;
-    for (const FacilityType &facility : other.facilitiesOptions)
-    {
-        facilitiesOptions.push_back(facility); // Uses copy constructor
-    }
-    // Deep copy actionsLog
-    for (BaseAction *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    for (Settlement *settlement : other.settlements)
-    {
-        settlements.push_back(new Settlement(*settlement));
-    }
-
-    // Deep copy plans
-    for (const auto &plan : other.plans)
-    {
-        Settlement *newSettlement = nullptr;
-        for (Settlement *copiedSettlement : settlements)
-        {
-            if (copiedSettlement->getName() == plan.getSettlement())
-            {
-                newSettlement = copiedSettlement;
-                break;
-            }
-        }
-
-        std::vector<Facility *> copiedFacilities;
-        for (Facility *facility : plan.getFacilities())
-        {
-            copiedFacilities.push_back(facility->clone());
-        }
-
-        std::vector<Facility *> copiedUnderConstruction;
-        for (Facility *facility : plan.getConstruction())
-        {
-            copiedUnderConstruction.push_back(facility->clone());
-        }
-
-        plans.emplace_back(
-            plan.getID(),
-            *newSettlement,
-            plan.getPolicy() ? plan.getPolicy()->clone() : nullptr,
-            facilitiesOptions,
-            plan.getlifeQualityScore(),
-            plan.getEconomyScore(),
-            plan.getEnvironmentScore(),
-            std::move(copiedFacilities),
-            std::move(copiedUnderConstruction));
-    }
+    actionsLog = other.actionsLog;
+    settlements = other.settlements;
+    facilitiesOptions = other.facilitiesOptions;
+    settlementIndex = other.settlementIndex;
+    plans = other.plans;
+    currentStep = other.currentStep;
+    calendar = other.calendar;
 
     return *this;
 }
@@ -423,9 +671,13 @@ Simulation::Simulation(Simulation&& other) noexcept
       actionsLog(std::move(other.actionsLog)),
       settlements(std::move(other.settlements)),
       facilitiesOptions(std::move(other.facilitiesOptions)),
-      plans(std::move(other.plans)){
+      settlementIndex(std::move(other.settlementIndex)),
+      plans(std::move(other.plans)),
+      currentStep(other.currentStep),
+      calendar(std::move(other.calendar)){
     other.isRunning = false;
     other.planCounter = 0;
+    other.currentStep = 0;
 }
 
 Simulation& Simulation::operator=(Simulation&& other) noexcept {
@@ -436,30 +688,17 @@ Simulation& Simulation::operator=(Simulation&& other) noexcept {
         plans = std::move(other.plans);
         settlements = std::move(other.settlements);
         facilitiesOptions = std::move(other.facilitiesOptions);
+        settlementIndex = std::move(other.settlementIndex);
+        currentStep = other.currentStep;
+        calendar = std::move(other.calendar);
 
         other.isRunning = false;
         other.planCounter = 0;
+        other.currentStep = 0;
     }
     return *this;
 }
 
+// Everything is released by its shared owners
 Simulation::~Simulation() {
-
-    for (BaseAction *action : actionsLog)
-    {
-        if(action)
-           delete action;
-        action=nullptr;
-    }
-    for (Settlement *settlement : settlements)
-    {
-        if(settlement)
-            delete settlement;
-        settlement = nullptr;
-    }
-    actionsLog.clear();
-    settlements.clear();
-    plans.clear();
-    facilitiesOptions.clear();
-
 }
\ No newline at end of file
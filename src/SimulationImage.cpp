@@ -0,0 +1,441 @@
+#include "SimulationImage.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "Simulation.h"
+#include "Action.h"
+#include "PolicyRegistry.h"
+using std::vector;
+
+static const char IMAGE_MAGIC[8] = {'S', 'I', 'M', 'I', 'M', 'A', 'G', 'E'};
+// Files of any other version are rejected
+static const uint32_t IMAGE_VERSION = 2;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const size_t HEADER_SIZE = sizeof(IMAGE_MAGIC) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t fnv1a(uint64_t hash, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+namespace {
+
+// Streams the payload to the file through a buffer, checksumming it on the way
+class ImageWriter {
+    public:
+        explicit ImageWriter(std::ofstream &out) : out(out), buffer(), checksum(FNV_OFFSET), size(0) {}
+
+        void writeBytes(const char *data, size_t length)
+        {
+            checksum = fnv1a(checksum, data, length);
+            size += length;
+            buffer.insert(buffer.end(), data, data + length);
+            if (buffer.size() >= (1 << 20))
+                flush();
+        }
+
+        template <typename T>
+        void write(T value)
+        {
+            writeBytes(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        void flush()
+        {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        uint64_t getChecksum() const { return checksum; }
+        uint64_t getSize() const { return size; }
+
+    private:
+        std::ofstream &out;
+        vector<char> buffer;
+        uint64_t checksum;
+        uint64_t size;
+};
+
+// Bounds-checked reads from the mapped payload
+class ImageReader {
+    public:
+        ImageReader(const char *data, size_t size) : data(data), size(size), position(0) {}
+
+        const char *readBytes(size_t length)
+        {
+            if (length > size - position)
+                throw std::runtime_error("Snapshot file is truncated");
+            const char *bytes = data + position;
+            position += length;
+            return bytes;
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            std::memcpy(&value, readBytes(sizeof(value)), sizeof(value));
+            return value;
+        }
+
+        // Reads a count and checks that at least count records of recordSize bytes follow
+        uint32_t readCount(size_t recordSize)
+        {
+            uint32_t count = read<uint32_t>();
+            if (recordSize != 0 && count > (size - position) / recordSize)
+                throw std::runtime_error("Snapshot file is truncated");
+            return count;
+        }
+
+        bool atEnd() const { return position == size; }
+
+    private:
+        const char *data;
+        size_t size;
+        size_t position;
+};
+
+// Assigns each distinct string an index in the string table
+class StringTable {
+    public:
+        StringTable() : strings(), indices() {}
+
+        uint32_t intern(const string &value)
+        {
+            std::unordered_map<string, uint32_t>::const_iterator found = indices.find(value);
+            if (found != indices.end())
+                return found->second;
+            uint32_t index = strings.size();
+            strings.push_back(value);
+            indices.emplace(value, index);
+            return index;
+        }
+
+        const vector<string> &getStrings() const { return strings; }
+
+    private:
+        vector<string> strings;
+        std::unordered_map<string, uint32_t> indices;
+};
+
+}
+
+bool SimulationImage::isImage(const string &data)
+{
+    return data.size() >= sizeof(IMAGE_MAGIC) && std::memcmp(data.data(), IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0;
+}
+
+void SimulationImage::save(const Simulation &simulation, const string &path)
+{
+    // Intern every string first, so the table can be written ahead of the records
+    StringTable strings;
+    vector<uint32_t> settlementNames;
+    for (const std::shared_ptr<const Settlement> &settlement : simulation.settlements)
+    {
+        settlementNames.push_back(strings.intern(settlement->getName()));
+    }
+    vector<uint32_t> facilityNames;
+    for (const FacilityType &facility : *simulation.facilitiesOptions)
+    {
+        facilityNames.push_back(strings.intern(facility.getName()));
+    }
+    vector<uint32_t> actionNames;
+    vector<uint8_t> actionStatuses;
+    ActionLog::Reader actions(simulation.actionsLog);
+    while (!actions.atEnd())
+    {
+        std::unique_ptr<BaseAction> action = actions.next();
+        actionNames.push_back(strings.intern(action->toString()));
+        actionStatuses.push_back(static_cast<uint8_t>(action->getStatus()));
+    }
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("Failed to create snapshot file: " + path);
+    // Room for the header, which is written once the checksum is known
+    out.write(string(HEADER_SIZE, '\0').data(), HEADER_SIZE);
+
+    ImageWriter writer(out);
+    writer.write<uint32_t>(strings.getStrings().size());
+    for (const string &value : strings.getStrings())
+    {
+        writer.write<uint32_t>(value.size());
+        writer.writeBytes(value.data(), value.size());
+    }
+
+    writer.write<int32_t>(simulation.planCounter);
+    writer.write<int64_t>(simulation.currentStep);
+
+    writer.write<uint32_t>(simulation.settlements.size());
+    for (size_t i = 0; i < simulation.settlements.size(); i++)
+    {
+        writer.write<uint32_t>(settlementNames[i]);
+        writer.write<uint8_t>(static_cast<uint8_t>(simulation.settlements[i]->getType()));
+    }
+
+    // The catalog goes column by column, the way it keeps its scores
+    const FacilityCatalog &catalog = *simulation.facilitiesOptions;
+    writer.write<uint32_t>(catalog.size());
+    for (uint32_t name : facilityNames)
+    {
+        writer.write<uint32_t>(name);
+    }
+    for (const FacilityType &facility : catalog)
+    {
+        writer.write<uint8_t>(static_cast<uint8_t>(facility.getCategory()));
+    }
+    for (const FacilityType &facility : catalog)
+    {
+        writer.write<int32_t>(facility.getCost());
+    }
+    for (const CowVector<int> *scores : {&catalog.getLifeQualityScores(), &catalog.getEconomyScores(), &catalog.getEnvironmentScores()})
+    {
+        for (int score : *scores)
+        {
+            writer.write<int32_t>(score);
+        }
+    }
+
+    writer.write<uint32_t>(simulation.plans.size());
+    vector<int> policyState;
+    for (const Plan &plan : simulation.plans)
+    {
+        writer.write<int32_t>(plan.plan_id);
+        writer.write<uint32_t>(*simulation.settlementIndex.find(plan.settlement->getName()));
+        writer.write<int32_t>(plan.policyId);
+        policyState.clear();
+        plan.selectionPolicy.get().saveState(policyState);
+        writer.write<uint32_t>(policyState.size());
+        for (int value : policyState)
+        {
+            writer.write<int32_t>(value);
+        }
+        writer.write<uint8_t>(static_cast<uint8_t>(plan.status));
+        writer.write<int32_t>(plan.life_quality_score);
+        writer.write<int32_t>(plan.economy_score);
+        writer.write<int32_t>(plan.environment_score);
+        writer.write<int64_t>(plan.clock);
+        // The per-type counts follow from the completion order, so only the order is stored
+        writer.write<uint32_t>(plan.completionOrder.size());
+        for (const Plan::CompletionBlock &block : plan.completionOrder)
+        {
+            writer.write<int32_t>(block.repeats);
+            writer.write<uint32_t>(block.types.size());
+            for (int type : block.types)
+            {
+                writer.write<int32_t>(type);
+            }
+        }
+        writer.write<uint32_t>(plan.constructionTypes.size());
+        for (size_t i = 0; i < plan.constructionTypes.size(); i++)
+        {
+            writer.write<int32_t>(plan.constructionTypes[i]);
+            writer.write<int32_t>(plan.constructionTimeLeft[i]);
+        }
+    }
+
+    writer.write<uint32_t>(actionNames.size());
+    for (size_t i = 0; i < actionNames.size(); i++)
+    {
+        writer.write<uint32_t>(actionNames[i]);
+        writer.write<uint8_t>(actionStatuses[i]);
+    }
+    writer.flush();
+
+    uint64_t payloadSize = writer.getSize();
+    uint64_t checksum = writer.getChecksum();
+    out.seekp(0);
+    out.write(IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    out.write(reinterpret_cast<const char *>(&IMAGE_VERSION), sizeof(IMAGE_VERSION));
+    out.write(reinterpret_cast<const char *>(&BYTE_ORDER_MARK), sizeof(BYTE_ORDER_MARK));
+    out.write(reinterpret_cast<const char *>(&payloadSize), sizeof(payloadSize));
+    out.write(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+    out.flush();
+    if (!out)
+        throw std::runtime_error("Failed to write snapshot file: " + path);
+}
+
+void SimulationImage::load(Simulation &simulation, const string &path)
+{
+    MappedFile file(path, "snapshot file");
+    ImageReader header(file.getData(), file.getSize());
+    if (file.getSize() < HEADER_SIZE || std::memcmp(header.readBytes(sizeof(IMAGE_MAGIC)), IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0)
+        throw std::runtime_error("Not a snapshot file: " + path);
+    if (header.read<uint32_t>() != IMAGE_VERSION)
+        throw std::runtime_error("Unsupported snapshot file version: " + path);
+    if (header.read<uint32_t>() != BYTE_ORDER_MARK)
+        throw std::runtime_error("Snapshot file was written on a machine with another byte order: " + path);
+    uint64_t payloadSize = header.read<uint64_t>();
+    uint64_t checksum = header.read<uint64_t>();
+    if (payloadSize != file.getSize() - HEADER_SIZE)
+        throw std::runtime_error("Snapshot file is truncated: " + path);
+    const char *payload = file.getData() + HEADER_SIZE;
+    if (fnv1a(FNV_OFFSET, payload, payloadSize) != checksum)
+        throw std::runtime_error("Snapshot file is corrupt: " + path);
+
+    ImageReader reader(payload, payloadSize);
+    uint32_t stringCount = reader.readCount(sizeof(uint32_t));
+    vector<string> strings;
+    strings.reserve(stringCount);
+    for (uint32_t i = 0; i < stringCount; i++)
+    {
+        uint32_t length = reader.read<uint32_t>();
+        const char *bytes = reader.readBytes(length);
+        strings.emplace_back(bytes, length);
+    }
+    auto stringAt = [&strings](uint32_t index) -> const string & {
+        if (index >= strings.size())
+            throw std::runtime_error("Snapshot file is corrupt");
+        return strings[index];
+    };
+
+    // Built on the side, so a bad file leaves the simulation as it was
+    Simulation loaded(simulation);
+    loaded.actionsLog.clear();
+    loaded.settlements.clear();
+    loaded.facilitiesOptions = std::make_shared<FacilityCatalog>();
+    loaded.settlementIndex.clear();
+    loaded.plans.clear();
+    loaded.calendar.clear();
+
+    loaded.planCounter = reader.read<int32_t>();
+    loaded.currentStep = reader.read<int64_t>();
+
+    uint32_t settlementCount = reader.readCount(sizeof(uint32_t) + sizeof(uint8_t));
+    for (uint32_t i = 0; i < settlementCount; i++)
+    {
+        const string &name = stringAt(reader.read<uint32_t>());
+        uint8_t type = reader.read<uint8_t>();
+        if (type > static_cast<uint8_t>(SettlementType::METROPOLIS))
+            throw std::runtime_error("Snapshot file is corrupt");
+        Settlement *settlement = new Settlement(name, static_cast<SettlementType>(type));
+        if (!loaded.addSettlement(settlement))
+        {
+            delete settlement;
+            throw std::runtime_error("Snapshot file is corrupt");
+        }
+    }
+
+    const size_t facilitySize = sizeof(uint32_t) + sizeof(uint8_t) + 4 * sizeof(int32_t);
+    uint32_t facilityCount = reader.readCount(facilitySize);
+    // One column per field, so field f of facility i is at fieldOffset(f) + i * fieldSize(f)
+    const char *facilities = reader.readBytes(facilityCount * facilitySize);
+    const size_t fieldSizes[6] = {sizeof(uint32_t), sizeof(uint8_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t)};
+    size_t fieldOffsets[6];
+    size_t offset = 0;
+    for (int f = 0; f < 6; f++)
+    {
+        fieldOffsets[f] = offset * facilityCount;
+        offset += fieldSizes[f];
+    }
+    auto field = [&](int f, uint32_t i, void *value) {
+        std::memcpy(value, facilities + fieldOffsets[f] + i * fieldSizes[f], fieldSizes[f]);
+    };
+    for (uint32_t i = 0; i < facilityCount; i++)
+    {
+        uint32_t name;
+        uint8_t category;
+        int32_t values[4]; // Cost and the three scores
+        field(0, i, &name);
+        field(1, i, &category);
+        for (int f = 0; f < 4; f++)
+        {
+            field(f + 2, i, &values[f]);
+        }
+        if (category > static_cast<uint8_t>(FacilityCategory::ENVIRONMENT))
+            throw std::runtime_error("Snapshot file is corrupt");
+        FacilityType facility(stringAt(name), static_cast<FacilityCategory>(category), values[0], values[1], values[2], values[3]);
+        if (!loaded.facilitiesOptions->add(facility))
+            throw std::runtime_error("Snapshot file is corrupt");
+    }
+
+    uint32_t planCount = reader.readCount(0);
+    vector<int> policyState;
+    for (uint32_t i = 0; i < planCount; i++)
+    {
+        int32_t planId = reader.read<int32_t>();
+        uint32_t settlement = reader.read<uint32_t>();
+        int32_t policyId = reader.read<int32_t>();
+        if (settlement >= loaded.settlements.size())
+            throw std::runtime_error("Snapshot file is corrupt");
+        if (!PolicyRegistry::isValid(policyId))
+            throw std::runtime_error("Snapshot file uses an unknown selection policy");
+
+        Plan plan(planId, loaded.settlements[settlement], policyId);
+        uint32_t stateSize = reader.readCount(sizeof(int32_t));
+        policyState.clear();
+        for (uint32_t j = 0; j < stateSize; j++)
+        {
+            policyState.push_back(reader.read<int32_t>());
+        }
+        plan.selectionPolicy.get().restoreState(policyState);
+
+        uint8_t status = reader.read<uint8_t>();
+        if (status > static_cast<uint8_t>(PlanStatus::BUSY))
+            throw std::runtime_error("Snapshot file is corrupt");
+        plan.status = static_cast<PlanStatus>(status);
+        plan.life_quality_score = reader.read<int32_t>();
+        plan.economy_score = reader.read<int32_t>();
+        plan.environment_score = reader.read<int32_t>();
+        plan.clock = reader.read<int64_t>();
+
+        uint32_t blockCount = reader.readCount(sizeof(int32_t) + sizeof(uint32_t));
+        plan.completionOrder.resize(blockCount);
+        for (uint32_t j = 0; j < blockCount; j++)
+        {
+            Plan::CompletionBlock &block = plan.completionOrder[j];
+            block.repeats = reader.read<int32_t>();
+            uint32_t typeCount = reader.readCount(sizeof(int32_t));
+            if (block.repeats <= 0 || typeCount == 0)
+                throw std::runtime_error("Snapshot file is corrupt");
+            block.types.resize(typeCount);
+            for (uint32_t k = 0; k < typeCount; k++)
+            {
+                int type = reader.read<int32_t>();
+                if (type < 0 || static_cast<uint32_t>(type) >= facilityCount)
+                    throw std::runtime_error("Snapshot file is corrupt");
+                block.types[k] = type;
+                if (plan.operationalCounts.size() <= static_cast<size_t>(type))
+                    plan.operationalCounts.resize(type + 1, 0);
+                plan.operationalCounts[type] += block.repeats;
+            }
+        }
+        uint32_t constructionSize = reader.readCount(2 * sizeof(int32_t));
+        plan.constructionTypes.resize(constructionSize);
+        plan.constructionTimeLeft.resize(constructionSize);
+        for (uint32_t j = 0; j < constructionSize; j++)
+        {
+            plan.constructionTypes[j] = reader.read<int32_t>();
+            plan.constructionTimeLeft[j] = reader.read<int32_t>();
+            if (plan.constructionTypes[j] < 0 || static_cast<uint32_t>(plan.constructionTypes[j]) >= facilityCount)
+                throw std::runtime_error("Snapshot file is corrupt");
+        }
+        loaded.plans.push_back(std::move(plan));
+        loaded.scheduleWake(loaded.plans.size() - 1);
+    }
+
+    uint32_t actionCount = reader.readCount(sizeof(uint32_t) + sizeof(uint8_t));
+    for (uint32_t i = 0; i < actionCount; i++)
+    {
+        const string &description = stringAt(reader.read<uint32_t>());
+        uint8_t status = reader.read<uint8_t>();
+        if (status > static_cast<uint8_t>(ActionStatus::ERROR))
+            throw std::runtime_error("Snapshot file is corrupt");
+        loaded.actionsLog.append(RecordedAction(description, static_cast<ActionStatus>(status)));
+    }
+    if (!reader.atEnd())
+        throw std::runtime_error("Snapshot file is corrupt");
+
+    simulation = std::move(loaded);
+}
@@ -0,0 +1,162 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+static std::unique_ptr<ThreadPool> sharedPool;
+
+ThreadPool::Range::Range() : next(0), end(0) {}
+
+ThreadPool::ThreadPool(int threadCount)
+    : threadCount(threadCount > 0 ? threadCount : 1)
+    , workers()
+    , ranges()
+    , mutex()
+    , wakeCv()
+    , doneCv()
+    , generation(0)
+    , pending(0)
+    , stopping(false)
+    , body(nullptr)
+    , count(0)
+    , grain(1)
+    , failure()
+{
+    ranges.reset(new Range[this->threadCount]);
+    // Participant 0 is the thread calling parallelFor
+    for (int i = 1; i < this->threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+int ThreadPool::getThreadCount() const
+{
+    return threadCount;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)> &body)
+{
+    if (count == 0)
+        return;
+    if (threadCount <= 1 || count == 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    // Several chunks per thread so that stealing can even out plans of uneven cost
+    size_t chunks = std::min(count, static_cast<size_t>(threadCount) * 8);
+    size_t grain = (count + chunks - 1) / chunks;
+    chunks = (count + grain - 1) / grain;
+    for (int p = 0; p < threadCount; p++)
+    {
+        ranges[p].next.store(p * chunks / threadCount);
+        ranges[p].end = (p + 1) * chunks / threadCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->body = &body;
+        this->count = count;
+        this->grain = grain;
+        failure = nullptr;
+        pending = threadCount - 1;
+        generation++;
+    }
+    wakeCv.notify_all();
+
+    runChunks(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [this] { return pending == 0; });
+        this->body = nullptr;
+        error = failure;
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ThreadPool::workerLoop(int self)
+{
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeCv.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+
+        lock.unlock();
+        runChunks(self);
+        lock.lock();
+
+        if (--pending == 0)
+            doneCv.notify_one();
+    }
+}
+
+bool ThreadPool::claimChunk(int owner, size_t &chunk)
+{
+    Range &range = ranges[owner];
+    if (range.next.load(std::memory_order_relaxed) >= range.end)
+        return false;
+    chunk = range.next.fetch_add(1);
+    return chunk < range.end;
+}
+
+void ThreadPool::runChunks(int self)
+{
+    try
+    {
+        size_t chunk;
+        // Own chunks first, then steal from the other participants in turn
+        for (int i = 0; i < threadCount; i++)
+        {
+            int owner = (self + i) % threadCount;
+            while (claimChunk(owner, chunk))
+            {
+                size_t begin = chunk * grain;
+                (*body)(begin, std::min(count, begin + grain));
+            }
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure)
+            failure = std::current_exception();
+    }
+}
+
+void ThreadPool::configure(int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    sharedPool.reset(new ThreadPool(threadCount));
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    if (!sharedPool)
+    {
+        sharedPool.reset(new ThreadPool(1));
+    }
+    return *sharedPool;
+}
@@ -1,19 +1,177 @@
 #include "Simulation.h"
+#include "Auxiliary.h"
+#include "SelectionPolicy.h"
+#include "ThreadPool.h"
+#include "LogWriter.h"
+#include "Replayer.h"
+#include "Benchmark.h"
+#include "SimulationImage.h"
 #include <iostream>
+#include <deque>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 
 using namespace std;
 
 Simulation* backup = nullptr;
+std::map<string, Simulation> snapshots; // Named backups
+std::deque<Simulation> undoJournal; // States from before the latest actions, oldest first
+size_t undoDepth = 0; // Most actions undo can go back through; 0 keeps no journal
+
+static void printUsage(){
+    cout << "usage: simulation <config_path> [--threads <count>] [--horizon <steps>] [--opt-weights <life>,<economy>,<environment>] [--undo <depth>] [--log-file <path>] [--log-fsync never|batch|always] [--replay <file>] [--compile-config <image>] [--bench-planning <plans>,<steps>] [--bench-commands <count>]" << endl;
+}
 
 int main(int argc, char** argv){
-    if(argc!=2){
-        cout << "usage: simulation <config_path>" << endl;
+    if(argc<2 || argc%2!=0){
+        printUsage();
+        return 0;
+    }
+    int horizon = 100;
+    int weights[3] = {1, 1, 1};
+    string logFile = "";
+    string replayFile = "";
+    string compiledFile = "";
+    int benchPlans = 0;
+    int benchSteps = 0;
+    int benchCommands = 0;
+    FsyncPolicy fsyncPolicy = FsyncPolicy::BATCH;
+    for(int i=2; i<argc; i+=2){
+        if(strcmp(argv[i], "--threads")==0){
+            // 0 uses one thread per core, 1 keeps stepping on the main thread only
+            int threads;
+            if(!Auxiliary::parseInt(argv[i+1], strlen(argv[i+1]), threads) || threads<0){
+                printUsage();
+                return 0;
+            }
+            ThreadPool::configure(threads);
+        }
+        else if(strcmp(argv[i], "--horizon")==0){
+            // Steps the "opt" policy looks ahead
+            horizon = atoi(argv[i+1]);
+        }
+        else if(strcmp(argv[i], "--opt-weights")==0){
+            if(sscanf(argv[i+1], "%d,%d,%d", &weights[0], &weights[1], &weights[2])!=3){
+                printUsage();
+                return 0;
+            }
+        }
+        else if(strcmp(argv[i], "--undo")==0){
+            // Journaling makes every change copy what it touches, so it is off by default
+            int depth = atoi(argv[i+1]);
+            if(depth<0){
+                printUsage();
+                return 0;
+            }
+            undoDepth = depth;
+        }
+        else if(strcmp(argv[i], "--log-file")==0){
+            // Every command run is also appended to this file, off the command path
+            logFile = argv[i+1];
+        }
+        else if(strcmp(argv[i], "--log-fsync")==0){
+            if(strcmp(argv[i+1], "never")==0) fsyncPolicy = FsyncPolicy::NEVER;
+            else if(strcmp(argv[i+1], "batch")==0) fsyncPolicy = FsyncPolicy::BATCH;
+            else if(strcmp(argv[i+1], "always")==0) fsyncPolicy = FsyncPolicy::ALWAYS;
+            else{
+                printUsage();
+                return 0;
+            }
+        }
+        else if(strcmp(argv[i], "--replay")==0){
+            // Replays the file instead of reading commands, then reports and exits
+            replayFile = argv[i+1];
+        }
+        else if(strcmp(argv[i], "--compile-config")==0){
+            // Writes the loaded config as an image that later runs take in its place
+            compiledFile = argv[i+1];
+        }
+        else if(strcmp(argv[i], "--bench-planning")==0){
+            // Times stepping that many "bal" and "opt" plans, then exits
+            if(sscanf(argv[i+1], "%d,%d", &benchPlans, &benchSteps)!=2 || benchPlans<=0 || benchSteps<=0){
+                printUsage();
+                return 0;
+            }
+        }
+        else if(strcmp(argv[i], "--bench-commands")==0){
+            // Times feeding that many command lines through the command handler, then exits
+            benchCommands = atoi(argv[i+1]);
+            if(benchCommands<=0){
+                printUsage();
+                return 0;
+            }
+        }
+        else{
+            printUsage();
+            return 0;
+        }
+    }
+    if(horizon<=0){
+        printUsage();
         return 0;
     }
+    HorizonSelection::configure(horizon, weights[0], weights[1], weights[2]);
+    if(!logFile.empty()){
+        try{
+            LogWriter::configure(logFile, fsyncPolicy);
+        }
+        catch(const std::runtime_error &e){
+            cout << "Error: " << e.what() << endl;
+            return 0;
+        }
+    }
     string configurationFile = argv[1];
     std::cout << configurationFile << "\n\n\n";
-    Simulation simulation(configurationFile);
-    simulation.start();
+    std::unique_ptr<Simulation> loaded;
+    try{
+        loaded.reset(new Simulation(configurationFile));
+    }
+    catch(const std::runtime_error &e){
+        cout << "Error: " << e.what() << endl;
+        return 0;
+    }
+    Simulation &simulation = *loaded;
+    if(!compiledFile.empty()){
+        try{
+            SimulationImage::save(simulation, compiledFile);
+            cout << "Compiled " << configurationFile << " into " << compiledFile << endl;
+        }
+        catch(const std::runtime_error &e){
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+    else if(benchPlans>0){
+        try{
+            Benchmark::planning(simulation, benchPlans, benchSteps, cout);
+        }
+        catch(const std::runtime_error &e){
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+    else if(benchCommands>0){
+        try{
+            Benchmark::commands(simulation, benchCommands, cout);
+        }
+        catch(const std::runtime_error &e){
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+    else if(!replayFile.empty()){
+        try{
+            Replayer replayer(simulation);
+            Replayer::printReport(replayer.replayFile(replayFile), cout);
+        }
+        catch(const std::runtime_error &e){
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+    else{
+        simulation.start();
+    }
 
      if(backup!=nullptr){
      	delete backup;